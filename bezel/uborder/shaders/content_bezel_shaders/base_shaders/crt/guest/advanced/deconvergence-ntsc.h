@@ -348,7 +348,7 @@ layout(location = 3) in vec2 border_uv;
 layout(location = 4) in vec2 bezel_uv;
 layout(location = 0) out vec4 FragColor;
 layout(set = 0, binding = 2) uniform sampler2D LinearizePass;
-layout(set = 0, binding = 3) uniform sampler2D AvgLumPass;
+layout(set = 0, binding = 3) uniform sampler2D AvgLum;
 layout(set = 0, binding = 4) uniform sampler2D GlowPass;
 layout(set = 0, binding = 5) uniform sampler2D BloomPass;
 layout(set = 0, binding = 6) uniform sampler2D PrePass0;
@@ -699,7 +699,7 @@ vec3 get_content(vec2 vTex, vec2 uv)
 {
 	vec4 SourceSize = global.OriginalSize;
 	
-	float lum = COMPAT_TEXTURE(AvgLumPass, vec2(0.5,0.5)).a;
+	float lum = COMPAT_TEXTURE(AvgLum, vec2(0.5,0.5)).a;
 	
 	float gamma_in = 1.0/COMPAT_TEXTURE(LinearizePass, vec2(0.25,0.25)).a;
 	float intera = COMPAT_TEXTURE(LinearizePass, vec2(0.75,0.25)).a;
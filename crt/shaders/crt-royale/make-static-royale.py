@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+
+"""
+Generates a constant-folded crt-royale variant from a parameter snapshot.
+
+The input is a crt-royale .slangp using shaders from src/ (crt-royale.slangp or
+a preset saved from RetroArch, #reference chains are followed), the parameter
+values found in it override the #pragma parameter defaults.  The generator
+writes:
+  <out dir>/shaders/<out name>/user-settings.h
+      user-settings.h with RUNTIME_SHADER_PARAMS_ENABLE disabled and every
+      *_static constant set from the snapshot, which makes bind-shader-params.h
+      and derived-settings-and-constants.h take their HARDCODE_SETTINGS paths;
+  <out dir>/shaders/<out name>/src/
+      a copy of src/ with the relative #includes fixed up, the remaining
+      global.<parameter> reads folded and the static selects pruned;
+  <out preset>
+      the input preset with its paths rebased and the parameter lines dropped.
+Mask type, sample mode, geometry mode, AA level/filter etc. are then compile
+time constants.  global.<parameter> reads are folded to the literal snapshot
+value, and the selects on mask_type, geom_mode and aa_level (the mask LUT
+choice, the sphere/alt/cylinder mapping and the tex2Daa() kernel chain in
+tex2Dantialias.h) are cut down to the taken branch in the copied sources, so
+the unused mask types, geometry modes and AA levels are not in the generated
+shaders at all instead of being left to the shader compiler to fold.
+
+Static-only options which have no runtime parameter (aa_level, aa_filter,
+beam_num_scanlines, mask_sinc_lobes, ...) can be set with --set NAME=VALUE,
+NAME being the constant name in user-settings.h.
+
+Usage: python3 make-static-royale.py [--set NAME=VALUE ...] IN.slangp OUT.slangp
+"""
+
+import argparse
+import os
+import re
+import shutil
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, 'src')
+USER_SETTINGS = os.path.join(HERE, 'user-settings.h')
+BIND_PARAMS = os.path.join(SRC, 'bind-shader-params.h')
+
+# user-settings.h constant -> expression of the runtime parameters
+STATICS = {
+    'crt_gamma_static': '{crt_gamma}',
+    'lcd_gamma_static': '{lcd_gamma}',
+    'levels_contrast_static': '{levels_contrast}',
+    'halation_weight_static': '{halation_weight}',
+    'diffusion_weight_static': '{diffusion_weight}',
+    'bloom_underestimate_levels_static': '{bloom_underestimate_levels}',
+    'bloom_excess_static': '{bloom_excess}',
+    'beam_min_sigma_static': '{beam_min_sigma}',
+    'beam_max_sigma_static': '{beam_max_sigma}',
+    'beam_spot_power_static': '{beam_spot_power}',
+    'beam_min_shape_static': '{beam_min_shape}',
+    'beam_max_shape_static': '{beam_max_shape}',
+    'beam_shape_power_static': '{beam_shape_power}',
+    'beam_horiz_filter_static': '{beam_horiz_filter}',
+    'beam_horiz_sigma_static': '{beam_horiz_sigma}',
+    'beam_horiz_linear_rgb_weight_static': '{beam_horiz_linear_rgb_weight}',
+    'convergence_offsets_r_static': 'float2({convergence_offset_x_r}, {convergence_offset_y_r})',
+    'convergence_offsets_g_static': 'float2({convergence_offset_x_g}, {convergence_offset_y_g})',
+    'convergence_offsets_b_static': 'float2({convergence_offset_x_b}, {convergence_offset_y_b})',
+    'interlace_detect_static': 'bool({interlace_detect_toggle})',
+    'interlace_1080i_static': 'bool({interlace_1080i})',
+    'interlace_bff_static': 'bool({interlace_bff})',
+    'aa_subpixel_r_offset_static': 'float2({aa_subpixel_r_offset_x_runtime}, {aa_subpixel_r_offset_y_runtime})',
+    'aa_cubic_c_static': '{aa_cubic_c}',
+    'aa_gauss_sigma_static': '{aa_gauss_sigma}',
+    'mask_type_static': '{mask_type}',
+    'mask_sample_mode_static': '{mask_sample_mode_desired}',
+    'mask_specify_num_triads_static': '{mask_specify_num_triads}',
+    'mask_triad_size_desired_static': '{mask_triad_size_desired}',
+    'mask_num_triads_desired_static': '{mask_num_triads_desired}',
+    'geom_mode_static': '{geom_mode_runtime}',
+    'geom_radius_static': '{geom_radius}',
+    'geom_view_dist_static': '{geom_view_dist}',
+    'geom_tilt_angle_static': 'float2({geom_tilt_angle_x}, {geom_tilt_angle_y})',
+    'geom_aspect_ratio_static': '{geom_aspect_ratio_x} / {geom_aspect_ratio_y}',
+    'geom_overscan_static': 'float2({geom_overscan_x}, {geom_overscan_y})',
+    'border_size_static': '{border_size}',
+    'border_darkness_static': '{border_darkness}',
+    'border_compress_static': '{border_compress}',
+}
+
+# runtime codepath switches which only matter with runtime parameters
+RUNTIME_DEFINES = ('RUNTIME_SHADER_PARAMS_ENABLE', 'RUNTIME_PHOSPHOR_BLOOM_SIGMA',
+                   'RUNTIME_ANTIALIAS_WEIGHTS', 'RUNTIME_ANTIALIAS_SUBPIXEL_OFFSETS',
+                   'RUNTIME_SCANLINES_HORIZ_FILTER_COLORSPACE', 'RUNTIME_GEOMETRY_TILT',
+                   'RUNTIME_GEOMETRY_MODE', 'FORCE_RUNTIME_PHOSPHOR_MASK_MODE_TYPE_SELECT')
+
+PRESET_LINE = re.compile(r'^\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*"?([^"#\n]*?)"?\s*(#.*)?$')
+PATH_KEY = re.compile(r'^shader\d+$')
+
+
+def fail(msg):
+    sys.exit('make-static-royale: ' + msg)
+
+
+def read_parameters():
+    """Returns the #pragma parameter defaults."""
+    with open(BIND_PARAMS) as f:
+        text = f.read()
+    return {m.group(1): m.group(2) for m in
+            re.finditer(r'^#pragma parameter (\w+) "[^"]*" (\S+)', text, re.M)}
+
+
+def read_preset(path, seen=()):
+    """Returns (lines, values) for a preset, #reference chains flattened.
+    lines holds (key, value) for every non-parameter setting in file order."""
+    path = os.path.abspath(path)
+    if path in seen:
+        fail('circular #reference at ' + path)
+    base = os.path.dirname(path)
+    lines, values = [], {}
+    with open(path) as f:
+        for raw in f:
+            ref = re.match(r'^\s*#reference\s+"?([^"\n]+)"?', raw)
+            if ref:
+                sub_lines, sub_values = read_preset(os.path.join(base, ref.group(1)), seen + (path,))
+                lines += sub_lines
+                values.update(sub_values)
+                continue
+            m = PRESET_LINE.match(raw)
+            if not m:
+                continue
+            key, value = m.group(1), m.group(2).strip()
+            if PATH_KEY.match(key) or key in values.get('textures', '').split(';'):
+                value = os.path.normpath(os.path.join(base, value))
+            lines.append((key, value))
+            if key == 'textures':
+                values['textures'] = value
+    return lines, values
+
+
+def settings(lines, defaults, overrides):
+    params = dict(defaults)
+    for key, value in lines:
+        if key in params:
+            params[key] = value
+    params = {k: repr(float(v)) for k, v in params.items()}
+    header = open(USER_SETTINGS).read()
+    for name in RUNTIME_DEFINES:
+        header = re.sub(r'^(\s*)#define %s\b' % name, r'\1//#define %s' % name, header, flags=re.M)
+
+    def bake(name, expr):
+        nonlocal header
+        pattern = r'^(\s*static const \w+ %s = )[^;]*;' % name
+        if not re.search(pattern, header, re.M):
+            fail('no constant %s in user-settings.h' % name)
+        header = re.sub(pattern, lambda m: m.group(1) + expr + ';', header, flags=re.M)
+
+    for name, expr in STATICS.items():
+        bake(name, expr.format(**params))
+    for name, expr in overrides.items():
+        bake(name, expr)
+    return params, header
+
+
+def static_selects(params, header):
+    """Returns the values the pruned selects are resolved against: mask_type is
+    clamped like bind-shader-params.h does, the last pass uses geom_mode_static
+    as is, and aa_level is the (possibly --set) user-settings.h constant."""
+    aa_level = re.search(r'^\s*static const float aa_level = ([^;]*);', header, re.M)
+    try:
+        aa_level = float(aa_level.group(1))
+    except (AttributeError, ValueError):
+        fail('aa_level in user-settings.h is not a literal')
+    return {'mask_type': min(max(float(params['mask_type']), 0.0), 2.0),
+            'geom_mode': float(params['geom_mode_runtime']),
+            'aa_level': aa_level}
+
+
+def block_end(text, start):
+    """Returns the index past the {} block opening at text[start]."""
+    depth = 0
+    for i in range(start, len(text)):
+        if text[i] == '{':
+            depth += 1
+        elif text[i] == '}':
+            depth -= 1
+            if not depth:
+                return i + 1
+    fail('unbalanced braces')
+
+
+def taken(op, threshold, value):
+    return value < threshold if op == '<' else value > threshold
+
+
+def prune_if_chains(text, name, value):
+    """Replaces if/else if/else chains testing only name against a constant
+    with the block that value selects."""
+    cond = r'if\s*\(\s*%s\s*([<>])\s*([0-9.]+)\s*\)\s*' % name
+    head = re.compile(r'(?<![\w.])' + cond + r'(?=\{)')
+    link = re.compile(r'\s*else\s*(?:' + cond + r')?(?=\{)')
+    while True:
+        m = head.search(text)
+        if not m:
+            return text
+        start, end, chosen = m.start(), block_end(text, m.end()), None
+        if taken(m.group(1), float(m.group(2)), value):
+            chosen = text[m.end():end]
+        while True:
+            e = link.match(text, end)
+            if not e:
+                break
+            if re.match(r'\s*else\s*if', text[end:]) and not e.group(1):
+                fail('else if on something other than %s' % name)
+            block = (e.end(), block_end(text, e.end()))
+            if chosen is None and (not e.group(1) or taken(e.group(1), float(e.group(2)), value)):
+                chosen = text[block[0]:block[1]]
+            end = block[1]
+        text = text[:start] + (chosen or '') + text[end:]
+
+
+def primary(expr):
+    """True for a name, swizzle or single call which needs no parentheses."""
+    call = re.match(r'\w+\s*\(', expr)
+    if not call:
+        return re.fullmatch(r'[\w.]+', expr) is not None
+    depth = 0
+    for i in range(call.end() - 1, len(expr)):
+        depth += {'(': 1, ')': -1}.get(expr[i], 0)
+        if not depth:
+            return re.fullmatch(r'(?:\.\w+)?', expr[i + 1:]) is not None
+    return False
+
+
+def prune_ternaries(text, name, value):
+    """Replaces ternaries whose whole condition is name against a constant with
+    the operand that value selects."""
+    cond = re.compile(r'(\(\s*)?(?<![\w.])%s\s*([<>])\s*([0-9.]+)\s*(?(1)\))\s*\?' % name)
+    while True:
+        #  Innermost (last) first, so a pruned chain collapses to its operand.
+        m = None
+        for m in cond.finditer(text):
+            pass
+        if not m:
+            return text
+        if not re.search(r'(?:[=(?:,]|\breturn)\s*$', text[:m.start()]):
+            fail('%s select is not a whole ternary condition' % name)
+        depth, nested, i, mid = 0, 0, m.end(), None
+        while i < len(text):
+            c = text[i]
+            if c in '([':
+                depth += 1
+            elif c in ')]':
+                if not depth:
+                    break
+                depth -= 1
+            elif not depth and c == '?':
+                nested += 1
+            elif not depth and c == ':':
+                if not nested and mid is None:
+                    mid = i
+                elif nested:
+                    nested -= 1
+            elif not depth and c in ';,':
+                break
+            i += 1
+        if mid is None:
+            fail('unterminated %s ternary' % name)
+        operand = (text[m.end():mid] if taken(m.group(2), float(m.group(3)), value) else text[mid + 1:i]).strip()
+        enclosed = re.search(r'\(\s*$', text[:m.start()]) and text[i] == ')'
+        if not enclosed and not primary(operand):
+            operand = '(' + operand + ')'
+        text = text[:m.start()] + operand + text[i:]
+
+
+def copy_sources(dest, params, selects):
+    """Copies src/ to dest, rebasing #includes, folding global.<param> to the
+    snapshot value and pruning the static selects."""
+    folded = re.compile(r'\bglobal\.(%s)\b' % '|'.join(sorted(params, key=len, reverse=True)))
+    for root, _, files in os.walk(SRC):
+        for name in files:
+            src_path = os.path.join(root, name)
+            dst_path = os.path.join(dest, 'src', os.path.relpath(src_path, SRC))
+            os.makedirs(os.path.dirname(dst_path), exist_ok=True)
+            if not name.endswith(('.slang', '.h', '.inc')):
+                shutil.copyfile(src_path, dst_path)
+                continue
+            with open(src_path, encoding='latin-1', newline='') as f:
+                text = f.read()
+
+            def rebase(m):
+                target = os.path.normpath(os.path.join(root, m.group(2)))
+                if target == USER_SETTINGS or target.startswith(SRC + os.sep):
+                    return m.group(0)
+                return m.group(1) + os.path.relpath(target, os.path.dirname(dst_path)).replace(os.sep, '/') + m.group(3)
+
+            text = re.sub(r'^(\s*#include\s+")([^"]+)(")', rebase, text, flags=re.M)
+            if name != 'bind-shader-params.h':
+                text = folded.sub(lambda m: params[m.group(1)], text)
+                for select, value in selects.items():
+                    text = prune_ternaries(prune_if_chains(text, select, value), select, value)
+            with open(dst_path, 'w', encoding='latin-1', newline='') as f:
+                f.write(text)
+
+
+def write_preset(path, lines, dest, params):
+    base = os.path.dirname(os.path.abspath(path))
+    textures = dict(lines).get('textures', '').split(';')
+    out = ['# Generated by crt/shaders/crt-royale/make-static-royale.py, do not edit.',
+           '# Parameters are baked into %s.' % os.path.relpath(os.path.join(dest, 'user-settings.h'), base).replace(os.sep, '/'),
+           '']
+    for key, value in lines:
+        if key in params or key == 'parameters':
+            continue
+        if PATH_KEY.match(key) or key in textures:
+            if value.startswith(SRC + os.sep):
+                value = os.path.join(dest, 'src', os.path.relpath(value, SRC))
+            value = os.path.relpath(value, base).replace(os.sep, '/')
+        out.append('%s = "%s"' % (key, value))
+    with open(path, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Generate a constant-folded crt-royale variant.')
+    parser.add_argument('--set', action='append', default=[], metavar='NAME=VALUE',
+                        help='override a user-settings.h constant')
+    parser.add_argument('input')
+    parser.add_argument('output')
+    args = parser.parse_args()
+
+    lines, _ = read_preset(args.input)
+    if not any(PATH_KEY.match(k) and v.startswith(SRC + os.sep) for k, v in lines):
+        fail('%s does not use crt-royale src/ shaders' % args.input)
+    overrides = dict(s.split('=', 1) for s in args.set)
+    params, header = settings(lines, read_parameters(), overrides)
+
+    stem = os.path.splitext(os.path.basename(args.output))[0]
+    dest = os.path.join(os.path.dirname(os.path.abspath(args.output)), 'shaders', stem)
+    if os.path.exists(os.path.join(dest, 'src')):
+        shutil.rmtree(os.path.join(dest, 'src'))
+    copy_sources(dest, params, static_selects(params, header))
+    with open(os.path.join(dest, 'user-settings.h'), 'w') as f:
+        f.write(header)
+    write_preset(args.output, lines, dest, params)
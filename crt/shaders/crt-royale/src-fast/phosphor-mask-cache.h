@@ -0,0 +1,72 @@
+#ifndef PHOSPHOR_MASK_CACHE_H
+#define PHOSPHOR_MASK_CACHE_H
+
+/////////////////////////////  GPL LICENSE NOTICE  /////////////////////////////
+
+//  crt-royale: A full-featured CRT shader, with cheese.
+//  Copyright (C) 2014 TroggleMonkey <trogglemonkey@gmx.com>
+//
+//  This program is free software; you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation; either version 2 of the License, or any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+//  Place, Suite 330, Boston, MA 02111-1307 USA
+
+
+/////////////////////////////////  DESCRIPTION  ////////////////////////////////
+
+//  The resized phosphor mask only depends on the mask parameters and the
+//  viewport size, so it rarely changes between frames.  The signature pass
+//  (crt-royale-mask-resize-signature.slang) writes those inputs into a tiny
+//  float MASK_SIGNATURE target, and the -cached mask resize passes copy their
+//  own feedback instead of Lanczos-resizing again while MASK_SIGNATURE matches
+//  MASK_SIGNATUREFeedback.
+//  Everything is stored as small integers or multiples of 1/8, split into
+//  256-sized digits where needed, so the values round-trip exactly through a
+//  half-float framebuffer and can be compared with ==.  Texel 0 always holds a
+//  1.0 marker, so the cleared feedback of the first frame never matches.
+
+//  Width of the MASK_SIGNATURE pass in texels (scale_x for scale_type absolute):
+const int mask_cache_signature_size = 3;
+
+vec2 mask_cache_split(const float value)
+{
+    return vec2(floor(value / 256.0), mod(value, 256.0));
+}
+
+vec4 get_mask_cache_signature(const int texel, const vec2 viewport_size)
+{
+    if(texel == 0)
+    {
+        return vec4(1.0, mask_type, global.mask_specify_num_triads,
+            global.mask_triad_size_desired);
+    }
+    else if(texel == 1)
+    {
+        return vec4(mask_cache_split(global.mask_num_triads_desired), 0.0, 0.0);
+    }
+    return vec4(mask_cache_split(viewport_size.x),
+        mask_cache_split(viewport_size.y));
+}
+
+bool mask_cache_is_valid(sampler2D signature, sampler2D signature_feedback)
+{
+    for(int i = 0; i < mask_cache_signature_size; ++i)
+    {
+        if(texelFetch(signature, ivec2(i, 0), 0) !=
+            texelFetch(signature_feedback, ivec2(i, 0), 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif  //  PHOSPHOR_MASK_CACHE_H
@@ -69,17 +69,19 @@ float2x2 mul_scale(float2 scale, float2x2 matrix)
     return mat2x2(temp_matrix.x, temp_matrix.y, temp_matrix.z, temp_matrix.w);
 }
 
+//  Everything but tex_uv depends only on uniforms, so it's flat (see
+//  include/flat-setup.h).
 #pragma stage vertex
 layout(location = 0) in vec4 Position;
 layout(location = 1) in vec2 TexCoord;
 layout(location = 0) out vec2 tex_uv;
-layout(location = 1) out vec4 video_and_texture_size_inv;
-layout(location = 2) out vec2 output_size_inv;
-layout(location = 3) out vec3 eye_pos_local;
-layout(location = 4) out vec4 geom_aspect_and_overscan;
-layout(location = 5) out vec3 global_to_local_row0;
-layout(location = 6) out vec3 global_to_local_row1;
-layout(location = 7) out vec3 global_to_local_row2;
+layout(location = 1) flat out vec4 video_and_texture_size_inv;
+layout(location = 2) flat out vec2 output_size_inv;
+layout(location = 3) flat out vec3 eye_pos_local;
+layout(location = 4) flat out vec4 geom_aspect_and_overscan;
+layout(location = 5) flat out vec3 global_to_local_row0;
+layout(location = 6) flat out vec3 global_to_local_row1;
+layout(location = 7) flat out vec3 global_to_local_row2;
 
 void main()
 {
@@ -149,13 +151,13 @@ void main()
 
 #pragma stage fragment
 layout(location = 0) in vec2 tex_uv;
-layout(location = 1) in vec4 video_and_texture_size_inv;
-layout(location = 2) in vec2 output_size_inv;
-layout(location = 3) in vec3 eye_pos_local;
-layout(location = 4) in vec4 geom_aspect_and_overscan;
-layout(location = 5) in vec3 global_to_local_row0;
-layout(location = 6) in vec3 global_to_local_row1;
-layout(location = 7) in vec3 global_to_local_row2;
+layout(location = 1) flat in vec4 video_and_texture_size_inv;
+layout(location = 2) flat in vec2 output_size_inv;
+layout(location = 3) flat in vec3 eye_pos_local;
+layout(location = 4) flat in vec4 geom_aspect_and_overscan;
+layout(location = 5) flat in vec3 global_to_local_row0;
+layout(location = 6) flat in vec3 global_to_local_row1;
+layout(location = 7) flat in vec3 global_to_local_row2;
 layout(location = 0) out vec4 FragColor;
 layout(set = 0, binding = 2) uniform sampler2D Source;
 #define input_texture Source
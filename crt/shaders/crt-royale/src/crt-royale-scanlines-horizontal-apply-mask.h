@@ -91,9 +91,10 @@ layout(location = 0) out vec2 video_uv;
 layout(location = 1) out vec2 scanline_tex_uv;
 layout(location = 2) out vec2 blur3x3_tex_uv;
 layout(location = 3) out vec2 halation_tex_uv;
-layout(location = 4) out vec2 scanline_texture_size_inv;
-layout(location = 5) out vec4 mask_tile_start_uv_and_size;
-layout(location = 6) out vec2 mask_tiles_per_screen;
+layout(location = 4) flat out vec2 scanline_texture_size_inv;
+layout(location = 5) flat out vec4 mask_tile_start_uv_and_size;
+layout(location = 6) flat out vec2 mask_tiles_per_screen;
+layout(location = 7) flat out float mask_amplify;
 
 void main()
 {
@@ -130,6 +131,7 @@ void main()
         mask_resize_texture_size, mask_resize_video_size, IN.output_size,
         mask_tiles_per_screen);
     //mask_tiles_per_screen = mask_tiles_per_screen;
+    mask_amplify = get_mask_amplify();
 }
 
 #pragma stage fragment
@@ -137,9 +139,10 @@ layout(location = 0) in vec2 video_uv;
 layout(location = 1) in vec2 scanline_tex_uv;
 layout(location = 2) in vec2 blur3x3_tex_uv;
 layout(location = 3) in vec2 halation_tex_uv;
-layout(location = 4) in vec2 scanline_texture_size_inv;
-layout(location = 5) in vec4 mask_tile_start_uv_and_size;
-layout(location = 6) in vec2 mask_tiles_per_screen;
+layout(location = 4) flat in vec2 scanline_texture_size_inv;
+layout(location = 5) flat in vec4 mask_tile_start_uv_and_size;
+layout(location = 6) flat in vec2 mask_tiles_per_screen;
+layout(location = 7) flat in float mask_amplify;
 layout(location = 0) out vec4 FragColor;
 layout(set = 0, binding = 2) uniform sampler2D Source;
 layout(set = 0, binding = 3) uniform sampler2D mask_grille_texture_large;
@@ -241,7 +244,7 @@ void main()
         #else
             static const float blur_contrast = 1.0;
         #endif
-        const float mask_amplify = get_mask_amplify();
+        //const float mask_amplify = mask_amplify;
         const float undim_factor = 1.0/auto_dim_factor;
         const float3 phosphor_emission =
             phosphor_emission_dim * undim_factor * mask_amplify;
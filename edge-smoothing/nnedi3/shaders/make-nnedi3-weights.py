@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+
+"""
+Packs the nnedi3 win8x4 weights baked into nnedi3-nns*-win8x4-pass1-luma.slang
+into nnedi3-win8x4-weights.png, the LUT read by nnedi3-lut-win8x4.inc.
+
+Layout: one row per neuron, the neuron counts stacked as 16, 32, 64, 128, 256
+(496 rows in total), 66 texels per row:
+  x =  0..31  weights of the first (softmax) dot product, 4*i + k for W(i, ...)
+  x = 32..63  weights of the second (prediction) dot product
+  x = 64      bias of the first dot product
+  x = 65      bias of the second dot product
+Every texel stores the raw bits of one float32, little endian, in RGBA8.
+nnedi3-lut-unpack.slang decodes it into a 17x496 RGBA32F pass, texel x
+holding the weights 4x..4x+3, which is what the kernel fetches.
+
+Usage: python3 make-nnedi3-weights.py  (run from this directory)
+"""
+
+import re
+import struct
+import zlib
+
+NEURONS = [16, 32, 64, 128, 256]
+WIDTH = 66
+
+
+def read_neurons(nns):
+    with open('nnedi3-nns%d-win8x4-pass1-luma.slang' % nns) as f:
+        src = f.read()
+    rows = []
+    for line in re.findall(r'^\tsum1=.*$', src, re.M):
+        sum1, sum2, ws = line.strip().split(';')[:3]
+        w1 = [int(v) for m in re.findall(r'W\(\d,([^)]*)\)', sum1) for v in m.split(',')]
+        w2 = [int(v) for m in re.findall(r'W\(\d,([^)]*)\)', sum2) for v in m.split(',')]
+        bias = [int(v) for v in re.match(r'WS\((.*)\)', ws).group(1).split(',')]
+        assert len(w1) == 32 and len(w2) == 32 and len(bias) == 2
+        rows.append(w1 + w2 + bias)
+    assert len(rows) == nns, 'nns%d: found %d neurons' % (nns, len(rows))
+    return rows
+
+
+def write_png(path, width, rows):
+    raw = b''.join(b'\x00' + b''.join(struct.pack('<i', v) for v in row) for row in rows)
+
+    def chunk(tag, data):
+        return struct.pack('>I', len(data)) + tag + data + struct.pack('>I', zlib.crc32(tag + data) & 0xffffffff)
+
+    with open(path, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', width, len(rows), 8, 6, 0, 0, 0)))
+        f.write(chunk(b'IDAT', zlib.compress(raw, 9)))
+        f.write(chunk(b'IEND', b''))
+
+
+if __name__ == '__main__':
+    rows = []
+    for nns in NEURONS:
+        rows += read_neurons(nns)
+    write_png('nnedi3-win8x4-weights.png', WIDTH, rows)
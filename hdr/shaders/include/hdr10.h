@@ -36,6 +36,35 @@ const mat3 kExpanded709_to_2020 = mat3 (
    -0.00121055f, 0.0176041f, 0.983607f);
 /* END Converted from (Copyright (c) Microsoft Corporation - Licensed under the MIT License.)  https://github.com/microsoft/Xbox-ATG-Samples/tree/master/Kits/ATGTK/HDR */
 
+// ------------------------------------------------------------------------------------------------
+// ST2084 (PQ) encode
+// ------------------------------------------------------------------------------------------------
+
+/* The exact encode costs three pow()s and a divide per channel. By default LinearToST2084() uses
+   a degree 10 polynomial in t = log2(L)/20 + 1 instead, one log2() and ten FMAs: the Chebyshev
+   interpolant of the encode over L = 2^-40..1, where L is linear light relative to 10,000 nits.
+   Its largest error is 0.098 of a 10-bit code value (0.39 of a 12-bit one). Black and anything
+   below 2^-40 encode as -7.2e-5, 0.075 of a 10-bit code below the exact curve, which the UNORM
+   back buffer stores as 0. Values above 10,000 nits encode as 1.0.
+   #define HDR10_EXACT_ST2084 before including this file to use the exact encode. */
+const float kST2084Poly[11] = {
+    2.098122026e-02f,  1.452916266e-01f,  4.475745878e-01f,  7.312483939e-01f,
+    4.241954150e-01f, -5.335293452e-01f, -7.848486997e-01f,  1.784959273e-01f,
+    5.431327213e-01f, -2.149790947e-02f, -1.510988146e-01f };
+
+vec3 LinearToST2084_Poly(const vec3 positive)
+{
+   const vec3 t = clamp(log2(max(positive, exp2(-40.0f))) * (1.0f / 20.0f) + 1.0f, -1.0f, 1.0f);
+
+   vec3 st2084 = vec3(kST2084Poly[10]);
+   for (int i = 9; i >= 0; i--)
+   {
+      st2084 = st2084 * t + kST2084Poly[i];
+   }
+
+   return st2084;
+}
+
 #ifdef SONY_MEGATRON_VERSION_2
 
 // ------------------------------------------------------------------------------------------------
@@ -110,7 +139,11 @@ vec3 LinearToST2084(const vec3 colour)
 {
 	const vec3 positive = max(colour, vec3(0.0f));
 	
+#ifdef HDR10_EXACT_ST2084
 	return vec3(LinearToST2084_1(positive.r), LinearToST2084_1(positive.g), LinearToST2084_1(positive.b));
+#else
+	return LinearToST2084_Poly(positive);
+#endif
 }
 
 mat3 GamutMatrix(uint colour_space, uint expand_gamut)
@@ -165,7 +198,11 @@ float LinearToST2084_1(const float channel)
 
 vec3 LinearToST2084(const vec3 colour)
 {
+#ifdef HDR10_EXACT_ST2084
 	return vec3(LinearToST2084_1(colour.r), LinearToST2084_1(colour.g), LinearToST2084_1(colour.b));
+#else
+	return LinearToST2084_Poly(abs(colour));
+#endif
 }
 
 /* Convert into HDR10 */
@@ -5,233 +5,293 @@
 
 #define kBeamWidth 0.5f
 
-const vec4 kFallOffControlPoints    = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-const vec4 kAttackControlPoints     = vec4(0.0f, 1.0f, 1.0f, 1.0f);
-//const vec4 kScanlineControlPoints = vec4(1.0f, 1.0f, 0.0f, 0.0f);
+// All three channels are generated together: each lane of a vec3 is one
+// channel with its own beam parameters. While the convergence offsets match
+// across channels every channel reads the same source texels, so each texel
+// is fetched once for all three; otherwise each channel of the mask texel
+// that is lit fetches its own, and the others are left at zero.
+
+// Cubic Bezier with the control points of each channel in one lane,
+// (p0, p1, p2, p3) * kCubicBezier expanded in power form
+vec3 Bezier(const vec3 t, const vec3 p0, const vec3 p1, const vec3 p2, const vec3 p3)
+{
+   const vec3 c1 = 3.0f * (p1 - p0);
+   const vec3 c2 = 3.0f * (p0 - 2.0f * p1 + p2);
+   const vec3 c3 = p3 - p0 + 3.0f * (p1 - p2);
 
-const mat4 kCubicBezier = mat4( 1.0f,  0.0f,  0.0f,  0.0f,
-                               -3.0f,  3.0f,  0.0f,  0.0f,
-                                3.0f, -6.0f,  3.0f,  0.0f,
-                               -1.0f,  3.0f, -3.0f,  1.0f );
+   return p0 + t * (c1 + t * (c2 + t * c3));
+}
 
-float Bezier(const float t0, const vec4 control_points)
+// Horizontal interpolation between two source pixels: the fall off curve
+// (0, outer, inner, 1) where the beam dims, the attack curve
+// (0, 1 - inner, 1 - outer, 1) where it brightens
+vec3 BeamInterpolation(const vec3 t, const vec3 beam_attack, const bvec3 falloff)
 {
-   vec4 t = vec4(1.0, t0, t0*t0, t0*t0*t0);
-   return dot(t, control_points * kCubicBezier);
+   const vec3 inner_attack = clamp(beam_attack, 0.0f, 1.0f);
+   const vec3 outer_attack = clamp(beam_attack - 1.0f, 0.0f, 1.0f);
+
+   const vec3 p1 = mix(vec3(1.0f) - inner_attack, outer_attack, falloff);
+   const vec3 p2 = mix(vec3(1.0f) - outer_attack, inner_attack, falloff);
+
+   return Bezier(t, vec3(0.0f), p1, p2, vec3(1.0f));
 }
 
-vec4 BeamControlPoints(const float beam_attack, const bool falloff)
+// Fetches channel c of the texel at (x[c], y[c]) for each lit channel
+vec3 SampleChannels(sampler2D source, const vec3 x, const vec3 y, const bvec3 lit)
 {
-   const float inner_attack = clamp(beam_attack, 0.0f, 1.0);
-   const float outer_attack = clamp(beam_attack - 1.0f, 0.0f, 1.0);
+   vec3 channels = vec3(0.0f);
 
-   return falloff ? kFallOffControlPoints + vec4(0.0f, outer_attack, inner_attack, 0.0f) : kAttackControlPoints - vec4(0.0f, inner_attack, outer_attack, 0.0f);
+   if (lit.r) channels.r = COMPAT_TEXTURE(source, vec2(x.r, y.r)).r;
+   if (lit.g) channels.g = COMPAT_TEXTURE(source, vec2(x.g, y.g)).g;
+   if (lit.b) channels.b = COMPAT_TEXTURE(source, vec2(x.b, y.b)).b;
+
+   return channels;
+}
+
+bool ChannelsConverged(const vec3 horizontal_convergence, const vec3 vertical_convergence)
+{
+   return all(equal(horizontal_convergence, horizontal_convergence.rrr)) &&
+          all(equal(vertical_convergence, vertical_convergence.rrr));
 }
 
 
 #ifdef SONY_MEGATRON_VERSION_2
 
-float ScanlineColour(const uint channel, 
-                  const vec2 tex_coord,
-                  const vec2 source_size, 
-                  const float scanline_size, 
-                  const float source_tex_coord_x, 
-                  const float narrowed_source_pixel_offset, 
-                  const float vertical_convergence, 
-                  const float beam_attack, 
-                  const float scanline_min, 
-                  const float scanline_max, 
-                  const float scanline_attack, 
-                  const float vertical_bias) 
+vec3 ScanlineColour( const bool converged,
+                     const bvec3 lit,
+                     const vec2 tex_coord,
+                     const vec2 source_size,
+                     const float scanline_size,
+                     const vec3 source_tex_coord_x,
+                     const vec3 narrowed_source_pixel_offset,
+                     const vec3 vertical_convergence,
+                     const vec3 beam_attack,
+                     const vec3 scanline_min,
+                     const vec3 scanline_max,
+                     const vec3 scanline_attack,
+                     const float vertical_bias)
 {
-   float current_source_position_y  = ((tex_coord.y * source_size.y) - vertical_convergence);
+   vec3 current_source_position_y   = ((tex_coord.y * source_size.y) - vertical_convergence);
+
+   vec3 center_line                 = floor(current_source_position_y) + 0.5 + vertical_bias;
+
+   vec3 distance_to_line            = current_source_position_y - center_line;
+
+   bvec3 on_line                    = lessThanEqual(abs(distance_to_line), vec3(1.5));
 
-   float center_line                = floor(current_source_position_y) + 0.5 + vertical_bias;
-   
-   float distance_to_line           = current_source_position_y - center_line;
-   
-   if (abs(distance_to_line) > 1.5) return 0.0;
+   if (!any(on_line)) return vec3(0.0);
 
-   float source_tex_coord_y         = center_line / source_size.y; 
+   vec3 source_tex_coord_y          = center_line / source_size.y;
+   vec3 source_tex_coord_x_1        = source_tex_coord_x + (1.0 / source_size.x);
 
-   vec2 tex_coord_0                 = vec2(source_tex_coord_x, source_tex_coord_y);
-   vec2 tex_coord_1                 = vec2(source_tex_coord_x + (1.0 / source_size.x), source_tex_coord_y);
+   vec3 hdr_channel_0;
+   vec3 hdr_channel_1;
 
-   float hdr_channel_0              = COMPAT_TEXTURE(SourceHDR, tex_coord_0)[channel];
-   float hdr_channel_1              = COMPAT_TEXTURE(SourceHDR, tex_coord_1)[channel];
+   if (converged)
+   {
+      hdr_channel_0                 = COMPAT_TEXTURE(SourceHDR, vec2(source_tex_coord_x.r, source_tex_coord_y.r)).rgb;
+      hdr_channel_1                 = COMPAT_TEXTURE(SourceHDR, vec2(source_tex_coord_x_1.r, source_tex_coord_y.r)).rgb;
+   }
+   else
+   {
+      hdr_channel_0                 = SampleChannels(SourceHDR, source_tex_coord_x, source_tex_coord_y, lit);
+      hdr_channel_1                 = SampleChannels(SourceHDR, source_tex_coord_x_1, source_tex_coord_y, lit);
+   }
 
-   float horiz_interp               = Bezier(narrowed_source_pixel_offset, BeamControlPoints(beam_attack, hdr_channel_0 > hdr_channel_1));  
-   float hdr_channel                = mix(hdr_channel_0, hdr_channel_1, horiz_interp);
+   vec3 horiz_interp                = BeamInterpolation(narrowed_source_pixel_offset, beam_attack, greaterThan(hdr_channel_0, hdr_channel_1));
+   vec3 hdr_channel                 = mix(hdr_channel_0, hdr_channel_1, horiz_interp);
 
-   float physics_signal             = hdr_channel;
+   vec3 physics_signal              = hdr_channel;
 
-   float signal_strength            = clamp(physics_signal, 0.0, 2.5); 
+   vec3 signal_strength             = clamp(physics_signal, 0.0, 2.5);
 
    float beam_width_adjustment      = (kBeamWidth / scanline_size);
-   float raw_distance               = abs(distance_to_line) - beam_width_adjustment;
-   float distance_adjusted          = max(0.0, raw_distance);
+   vec3 raw_distance                = abs(distance_to_line) - beam_width_adjustment;
+   vec3 distance_adjusted           = max(vec3(0.0), raw_distance);
 
-   float effective_distance         = distance_adjusted * 2.0;
+   vec3 effective_distance          = distance_adjusted * 2.0;
 
-   float beam_width                 = mix(scanline_min, scanline_max, min(signal_strength, 1.0));
+   vec3 beam_width                  = mix(scanline_min, scanline_max, min(signal_strength, 1.0));
 
-   if (signal_strength > 1.0)
-   {
-      beam_width += (signal_strength - 1.0f) * HCRT_BLOOM_STRENGTH; 
-   }
+   beam_width                      += max(signal_strength - 1.0f, 0.0f) * HCRT_BLOOM_STRENGTH;
 
-   float channel_scanline_distance  = clamp(effective_distance / beam_width, 0.0f, 1.0f);
+   vec3 channel_scanline_distance   = clamp(effective_distance / beam_width, 0.0f, 1.0f);
 
-   vec4 channel_control_points      = vec4(1.0f, 1.0f, min(signal_strength, 1.0f) * scanline_attack, 0.0f);
-   float luminance                  = Bezier(channel_scanline_distance, channel_control_points);
+   vec3 luminance                   = Bezier(channel_scanline_distance, vec3(1.0f), vec3(1.0f), min(signal_strength, 1.0f) * scanline_attack, vec3(0.0f));
 
-   return luminance * hdr_channel;
+   return mix(vec3(0.0), luminance * hdr_channel, on_line);
 }
 
-float GenerateScanline( const uint channel, 
-                        const vec2 tex_coord,
-                        const vec2 source_size, 
-                        const float scanline_size, 
-                        const float horizontal_convergence, 
-                        const float vertical_convergence, 
-                        const float beam_sharpness, 
-                        const float beam_attack, 
-                        const float scanline_min, 
-                        const float scanline_max, 
-                        const float scanline_attack)
+vec3 GenerateScanline(  const vec2 tex_coord,
+                        const vec2 source_size,
+                        const float scanline_size,
+                        const vec3 horizontal_convergence,
+                        const vec3 vertical_convergence,
+                        const vec3 beam_sharpness,
+                        const vec3 beam_attack,
+                        const vec3 scanline_min,
+                        const vec3 scanline_max,
+                        const vec3 scanline_attack,
+                        const vec3 channel_mask)
 {
-   float current_source_position_x      = (tex_coord.x * source_size.x) - horizontal_convergence;
-   float current_source_center_x        = floor(current_source_position_x) + 0.5; 
-   float source_tex_coord_x             = current_source_center_x / source_size.x; 
-   float source_pixel_offset            = fract(current_source_position_x);
-   float narrowed_source_pixel_offset   = clamp(((source_pixel_offset - 0.5) * beam_sharpness) + 0.5, 0.0, 1.0);
-
-   float total_light = ScanlineColour( channel, tex_coord, source_size, scanline_size, source_tex_coord_x, 
-                                       narrowed_source_pixel_offset, vertical_convergence, beam_attack, 
-                                       scanline_min, scanline_max, scanline_attack, 
-                                       0.0); 
-
-   total_light += ScanlineColour( channel, tex_coord, source_size, scanline_size, source_tex_coord_x, 
-                                 narrowed_source_pixel_offset, vertical_convergence, beam_attack, 
-                                 scanline_min, scanline_max, scanline_attack, 
+   bool converged                       = ChannelsConverged(horizontal_convergence, vertical_convergence);
+   bvec3 lit                            = greaterThan(channel_mask, vec3(0.0f));
+
+   vec3 current_source_position_x       = (tex_coord.x * source_size.x) - horizontal_convergence;
+   vec3 current_source_center_x         = floor(current_source_position_x) + 0.5;
+   vec3 source_tex_coord_x              = current_source_center_x / source_size.x;
+   vec3 source_pixel_offset             = fract(current_source_position_x);
+   vec3 narrowed_source_pixel_offset    = clamp(((source_pixel_offset - 0.5) * beam_sharpness) + 0.5, 0.0, 1.0);
+
+   vec3 total_light = ScanlineColour(  converged, lit, tex_coord, source_size, scanline_size, source_tex_coord_x,
+                                       narrowed_source_pixel_offset, vertical_convergence, beam_attack,
+                                       scanline_min, scanline_max, scanline_attack,
+                                       0.0);
+
+   total_light += ScanlineColour(converged, lit, tex_coord, source_size, scanline_size, source_tex_coord_x,
+                                 narrowed_source_pixel_offset, vertical_convergence, beam_attack,
+                                 scanline_min, scanline_max, scanline_attack,
                                  1.0);
 
-   total_light += ScanlineColour( channel, tex_coord, source_size, scanline_size, source_tex_coord_x, 
-                                 narrowed_source_pixel_offset, vertical_convergence, beam_attack, 
-                                 scanline_min, scanline_max, scanline_attack, 
+   total_light += ScanlineColour(converged, lit, tex_coord, source_size, scanline_size, source_tex_coord_x,
+                                 narrowed_source_pixel_offset, vertical_convergence, beam_attack,
+                                 scanline_min, scanline_max, scanline_attack,
                                  -1.0);
 
    return total_light;
-} 
+}
 
 #else // !SONY_MEGATRON_VERSION_2
 
-float ScanlineColour(const uint channel, 
+vec3 ScanlineColour( const bool converged,
+                     const bvec3 lit,
                      const vec2 tex_coord,
-                     const vec2 source_size, 
-                     const float scanline_size, 
-                     const float source_tex_coord_x, 
-                     const float narrowed_source_pixel_offset, 
-                     const float vertical_convergence, 
-                     const float beam_attack, 
-                     const float scanline_min, 
-                     const float scanline_max, 
-                     const float scanline_attack, 
-                     inout float next_prev)
+                     const vec2 source_size,
+                     const float scanline_size,
+                     const vec3 source_tex_coord_x,
+                     const vec3 narrowed_source_pixel_offset,
+                     const vec3 vertical_convergence,
+                     const vec3 beam_attack,
+                     const vec3 scanline_min,
+                     const vec3 scanline_max,
+                     const vec3 scanline_attack,
+                     inout vec3 next_prev)
 {
-   const float current_source_position_y  = ((tex_coord.y * source_size.y) - vertical_convergence) + next_prev;
-   const float current_source_center_y    = floor(current_source_position_y) + 0.5f; 
-   
-   const float source_tex_coord_y         = current_source_center_y / source_size.y; 
+   const vec3 current_source_position_y   = ((tex_coord.y * source_size.y) - vertical_convergence) + next_prev;
+   const vec3 current_source_center_y     = floor(current_source_position_y) + 0.5f;
 
-   const float scanline_delta             = fract(current_source_position_y) - 0.5f;
+   const vec3 source_tex_coord_y          = current_source_center_y / source_size.y;
+
+   const vec3 scanline_delta              = fract(current_source_position_y) - 0.5f;
 
    // Slightly increase the beam width to get maximum brightness
-   float beam_distance                    = abs(scanline_delta - next_prev) - (kBeamWidth / scanline_size);
-   beam_distance                          = beam_distance < 0.0f ? 0.0f : beam_distance;
-   const float scanline_distance          = beam_distance * 2.0f;
+   vec3 beam_distance                     = abs(scanline_delta - next_prev) - (kBeamWidth / scanline_size);
+   beam_distance                          = max(beam_distance, 0.0f);
+   const vec3 scanline_distance           = beam_distance * 2.0f;
+
+   next_prev = mix(vec3(-1.0f), vec3(1.0f), greaterThan(scanline_delta, vec3(0.0f)));
 
-   next_prev = scanline_delta > 0.0f ? 1.0f : -1.0f;
+   const vec3 source_tex_coord_x_1        = source_tex_coord_x + (1.0f / source_size.x);
 
-   const vec2 tex_coord_0                 = vec2(source_tex_coord_x, source_tex_coord_y);
-   const vec2 tex_coord_1                 = vec2(source_tex_coord_x + (1.0f / source_size.x), source_tex_coord_y);
+   vec3 sdr_channel_0, sdr_channel_1, hdr_channel_0, hdr_channel_1;
+
+   if (converged)
+   {
+      const vec2 tex_coord_0              = vec2(source_tex_coord_x.r, source_tex_coord_y.r);
+      const vec2 tex_coord_1              = vec2(source_tex_coord_x_1.r, source_tex_coord_y.r);
 
-   const float sdr_channel_0              = COMPAT_TEXTURE(SourceSDR, tex_coord_0)[channel];
-   const float sdr_channel_1              = COMPAT_TEXTURE(SourceSDR, tex_coord_1)[channel];
+      sdr_channel_0                       = COMPAT_TEXTURE(SourceSDR, tex_coord_0).rgb;
+      sdr_channel_1                       = COMPAT_TEXTURE(SourceSDR, tex_coord_1).rgb;
 
-   const float hdr_channel_0              = COMPAT_TEXTURE(SourceHDR, tex_coord_0)[channel];
-   const float hdr_channel_1              = COMPAT_TEXTURE(SourceHDR, tex_coord_1)[channel];
+      hdr_channel_0                       = COMPAT_TEXTURE(SourceHDR, tex_coord_0).rgb;
+      hdr_channel_1                       = COMPAT_TEXTURE(SourceHDR, tex_coord_1).rgb;
+   }
+   else
+   {
+      sdr_channel_0                       = SampleChannels(SourceSDR, source_tex_coord_x, source_tex_coord_y, lit);
+      sdr_channel_1                       = SampleChannels(SourceSDR, source_tex_coord_x_1, source_tex_coord_y, lit);
 
-   /* Horizontal interpolation between pixels */ 
-   const float horiz_interp               = Bezier(narrowed_source_pixel_offset, BeamControlPoints(beam_attack, sdr_channel_0 > sdr_channel_1));  
+      hdr_channel_0                       = SampleChannels(SourceHDR, source_tex_coord_x, source_tex_coord_y, lit);
+      hdr_channel_1                       = SampleChannels(SourceHDR, source_tex_coord_x_1, source_tex_coord_y, lit);
+   }
 
-   const float hdr_channel                = mix(hdr_channel_0, hdr_channel_1, horiz_interp);
-   const float sdr_channel                = mix(sdr_channel_0, sdr_channel_1, horiz_interp);
+   /* Horizontal interpolation between pixels */
+   const vec3 horiz_interp                = BeamInterpolation(narrowed_source_pixel_offset, beam_attack, greaterThan(sdr_channel_0, sdr_channel_1));
 
-   const float channel_scanline_distance  = clamp(scanline_distance / ((sdr_channel * (scanline_max - scanline_min)) + scanline_min), 0.0f, 1.0f);
+   const vec3 hdr_channel                 = mix(hdr_channel_0, hdr_channel_1, horiz_interp);
+   const vec3 sdr_channel                 = mix(sdr_channel_0, sdr_channel_1, horiz_interp);
 
-   const vec4 channel_control_points      = vec4(1.0f, 1.0f, sdr_channel * scanline_attack,    0.0f);
+   const vec3 channel_scanline_distance   = clamp(scanline_distance / ((sdr_channel * (scanline_max - scanline_min)) + scanline_min), 0.0f, 1.0f);
 
-   const float luminance                  = Bezier(channel_scanline_distance, channel_control_points);
+   const vec3 luminance                   = Bezier(channel_scanline_distance, vec3(1.0f), vec3(1.0f), sdr_channel * scanline_attack, vec3(0.0f));
 
    return luminance * hdr_channel;
 }
 
-float GenerateScanline( const uint channel, 
-                        const vec2 tex_coord,
-                        const vec2 source_size, 
-                        const float scanline_size, 
-                        const float horizontal_convergence, 
-                        const float vertical_convergence, 
-                        const float beam_sharpness, 
-                        const float beam_attack, 
-                        const float scanline_min, 
-                        const float scanline_max, 
-                        const float scanline_attack)
+vec3 GenerateScanline(  const vec2 tex_coord,
+                        const vec2 source_size,
+                        const float scanline_size,
+                        const vec3 horizontal_convergence,
+                        const vec3 vertical_convergence,
+                        const vec3 beam_sharpness,
+                        const vec3 beam_attack,
+                        const vec3 scanline_min,
+                        const vec3 scanline_max,
+                        const vec3 scanline_attack,
+                        const vec3 channel_mask)
 {
-   const float current_source_position_x      = (tex_coord.x * source_size.x) - horizontal_convergence;
-   const float current_source_center_x        = floor(current_source_position_x) + 0.5f; 
-   
-   const float source_tex_coord_x             = current_source_center_x / source_size.x; 
+   const bool converged                       = ChannelsConverged(horizontal_convergence, vertical_convergence);
+   const bvec3 lit                            = greaterThan(channel_mask, vec3(0.0f));
+
+   const vec3 current_source_position_x       = (tex_coord.x * source_size.x) - horizontal_convergence;
+   const vec3 current_source_center_x         = floor(current_source_position_x) + 0.5f;
 
-   const float source_pixel_offset            = fract(current_source_position_x);
+   const vec3 source_tex_coord_x              = current_source_center_x / source_size.x;
 
-   const float narrowed_source_pixel_offset   = clamp(((source_pixel_offset - 0.5f) * beam_sharpness) + 0.5f, 0.0f, 1.0f);
+   const vec3 source_pixel_offset             = fract(current_source_position_x);
 
-   float next_prev = 0.0f;
+   const vec3 narrowed_source_pixel_offset    = clamp(((source_pixel_offset - 0.5f) * beam_sharpness) + 0.5f, 0.0f, 1.0f);
 
-   const float scanline_colour0  = ScanlineColour( channel, 
+   vec3 next_prev = vec3(0.0f);
+
+   const vec3 scanline_colour0   = ScanlineColour( converged,
+                                                   lit,
                                                    tex_coord,
-                                                   source_size, 
-                                                   scanline_size, 
-                                                   source_tex_coord_x, 
-                                                   narrowed_source_pixel_offset, 
-                                                   vertical_convergence,  
-                                                   beam_attack, 
-                                                   scanline_min, 
-                                                   scanline_max, 
-                                                   scanline_attack, 
+                                                   source_size,
+                                                   scanline_size,
+                                                   source_tex_coord_x,
+                                                   narrowed_source_pixel_offset,
+                                                   vertical_convergence,
+                                                   beam_attack,
+                                                   scanline_min,
+                                                   scanline_max,
+                                                   scanline_attack,
                                                    next_prev);
 
    // Optionally sample the neighbouring scanline
-   float scanline_colour1 = 0.0f;
-   if(scanline_max > 1.0f)
+   const bvec3 wide_beam = greaterThan(scanline_max * channel_mask, vec3(1.0f));
+
+   vec3 scanline_colour1 = vec3(0.0f);
+   if(any(wide_beam))
    {
-      scanline_colour1           = ScanlineColour( channel, 
+      scanline_colour1           = ScanlineColour( converged,
+                                                   lit,
                                                    tex_coord,
-                                                   source_size, 
-                                                   scanline_size, 
-                                                   source_tex_coord_x, 
+                                                   source_size,
+                                                   scanline_size,
+                                                   source_tex_coord_x,
                                                    narrowed_source_pixel_offset,
-                                                   vertical_convergence,  
-                                                   beam_attack, 
-                                                   scanline_min, 
-                                                   scanline_max, 
-                                                   scanline_attack,  
+                                                   vertical_convergence,
+                                                   beam_attack,
+                                                   scanline_min,
+                                                   scanline_max,
+                                                   scanline_attack,
                                                    next_prev);
+
+      scanline_colour1           = mix(vec3(0.0f), scanline_colour1, wide_beam);
    }
 
    return scanline_colour0 + scanline_colour1;
 }
 
-#endif // SONY_MEGATRON_VERSION_2
\ No newline at end of file
+#endif // SONY_MEGATRON_VERSION_2
@@ -1489,59 +1489,29 @@ void main()
 
    if(channel_count > 0)
    {
-      const uint channel_0             = (colour_mask >> kFirstChannelShift) & 3;
-
-      const float scanline_channel_0   = GenerateScanline(  channel_0,
-                                                            tex_coord,
-                                                            source_size.xy, 
-                                                            scanline_size, 
-                                                            horizontal_convergence[channel_0], 
-                                                            vertical_convergence[channel_0], 
-                                                            beam_sharpness[channel_0], 
-                                                            beam_attack[channel_0], 
-                                                            scanline_min[channel_0], 
-                                                            scanline_max[channel_0], 
-                                                            scanline_attack[channel_0]);
-
-      scanline_colour =  scanline_channel_0 * kColourMask[channel_0];
-   }
+      vec3 channel_mask = kColourMask[(colour_mask >> kFirstChannelShift) & 3];
 
-   if(channel_count > 1)
-   {
-      const uint channel_1             = (colour_mask >> kSecondChannelShift) & 3;
-
-      const float scanline_channel_1   = GenerateScanline(channel_1,
-                                                          tex_coord,
-                                                          source_size.xy, 
-                                                          scanline_size, 
-                                                          horizontal_convergence[channel_1], 
-                                                          vertical_convergence[channel_1], 
-                                                          beam_sharpness[channel_1], 
-                                                          beam_attack[channel_1], 
-                                                          scanline_min[channel_1], 
-                                                          scanline_max[channel_1], 
-                                                          scanline_attack[channel_1]);
-
-      scanline_colour += scanline_channel_1 * kColourMask[channel_1];
-   }
+      if(channel_count > 1)
+      {
+         channel_mask += kColourMask[(colour_mask >> kSecondChannelShift) & 3];
+      }
 
-   if(channel_count > 2)
-   {
-      const uint channel_2             = (colour_mask >> kThirdChannelShift) & 3;
-
-      const float scanline_channel_2   = GenerateScanline(channel_2,
-                                                          tex_coord,
-                                                          source_size.xy, 
-                                                          scanline_size, 
-                                                          horizontal_convergence[channel_2], 
-                                                          vertical_convergence[channel_2], 
-                                                          beam_sharpness[channel_2], 
-                                                          beam_attack[channel_2], 
-                                                          scanline_min[channel_2], 
-                                                          scanline_max[channel_2], 
-                                                          scanline_attack[channel_2]);
-
-      scanline_colour += scanline_channel_2 * kColourMask[channel_2];
+      if(channel_count > 2)
+      {
+         channel_mask += kColourMask[(colour_mask >> kThirdChannelShift) & 3];
+      }
+
+      scanline_colour   = GenerateScanline(tex_coord,
+                                           source_size.xy, 
+                                           scanline_size, 
+                                           horizontal_convergence, 
+                                           vertical_convergence, 
+                                           beam_sharpness, 
+                                           beam_attack, 
+                                           scanline_min, 
+                                           scanline_max, 
+                                           scanline_attack,
+                                           channel_mask) * channel_mask;
    }
 
    vec3 transformed_colour;
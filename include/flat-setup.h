@@ -0,0 +1,32 @@
+#ifndef FLAT_SETUP_H
+#define FLAT_SETUP_H
+
+//  Convention for values that depend only on uniforms and push constants:
+//  compute them once per vertex and hand them to the fragment stage as flat
+//  varyings, instead of once per output pixel. Every vertex of the quad
+//  computes the same value, so the result is exact, and flat varyings skip
+//  interpolation (integer and matrix types work too).
+//
+//  List the values once, before the first #pragma stage, so both stages
+//  declare the same locations:
+//      #include "../../include/flat-setup.h"
+//      #define EASU_SETUP(X) \
+//          X(1, uvec4, con0) \
+//          X(2, uvec4, con1)
+//  then declare them with
+//      #pragma stage vertex
+//      EASU_SETUP(FLAT_SETUP_OUT)
+//      ...
+//      #pragma stage fragment
+//      EASU_SETUP(FLAT_SETUP_IN)
+//  and assign them in the vertex main(). Start the locations after the
+//  pass's other varyings; a mat3 takes three locations and a mat4 four.
+//  Keep the total under 16 locations.
+//
+//  Values a pass only needs at compile time (static settings, #defines)
+//  should stay in the fragment stage, where the compiler folds them.
+
+#define FLAT_SETUP_OUT(loc, type, name) layout(location = loc) flat out type name;
+#define FLAT_SETUP_IN(loc, type, name)  layout(location = loc) flat in type name;
+
+#endif  //  FLAT_SETUP_H
@@ -0,0 +1,88 @@
+#ifndef LUT_SAMPLING_H
+#define LUT_SAMPLING_H
+
+//  Shared lookup for 3D colour LUTs stored as 2D strips: size tiles of
+//  size x size texels side by side (256x16, 1024x32 and 4096x64 images), red
+//  running along x inside a tile, green along y and blue selecting the tile.
+//
+//  lut_trilinear(lut, c, size)
+//      Two bilinear fetches from the neighbouring blue tiles, blended by the
+//      blue fraction. The LUT must be loaded with <Name>_linear = true.
+//  lut_tetrahedral(lut, c, size)
+//      Four texelFetch()es at the corners of the tetrahedron holding c,
+//      which keeps the grey axis and hue lines straighter than trilinear.
+//      Independent of the LUT filter setting.
+//  lut_nearest_slice(lut, c, size)
+//      One bilinear fetch from the nearest blue tile. This is the fast path
+//      for 16^3 grading LUTs; the blue error is at most half a tile step.
+//  lut_sample(lut, c, size, mode)
+//      Picks one of the above: mode 0 trilinear, 1 tetrahedral, 2 fast.
+//      Consumers expose it as
+//      #pragma parameter LUT_INTERP "LUT Interpolation: Trilinear | Tetrahedral | Fast" 0.0 0.0 2.0 1.0
+//
+//  The input colour is clamped to [0, 1]. Only #include in the fragment stage.
+//  Grade's shaders #define rg, gr, bg etc. as parameters, so avoid those
+//  names and swizzles here.
+
+// red and green texel centres inside the first tile
+vec2 lut_rg_coord(vec3 c, float size)
+{
+	return (c.xy * (size - 1.0) + 0.5) / vec2(size * size, size);
+}
+
+vec3 lut_trilinear(sampler2D lut, vec3 c, float size)
+{
+	c = clamp(c, 0.0, 1.0);
+	vec2 uv = lut_rg_coord(c, size);
+	float b = c.b * (size - 1.0);
+	float b0 = min(floor(b), size - 2.0);
+	vec3 c0 = texture(lut, vec2(b0 / size, 0.0) + uv).rgb;
+	vec3 c1 = texture(lut, vec2((b0 + 1.0) / size, 0.0) + uv).rgb;
+	return mix(c0, c1, b - b0);
+}
+
+vec3 lut_texel(sampler2D lut, vec3 i, float size)
+{
+	return texelFetch(lut, ivec2(int(i.b * size + i.r), int(i.g)), 0).rgb;
+}
+
+vec3 lut_tetrahedral(sampler2D lut, vec3 c, float size)
+{
+	vec3 p = clamp(c, 0.0, 1.0) * (size - 1.0);
+	vec3 i0 = min(floor(p), vec3(size - 2.0));
+	vec3 f = p - i0;
+
+	// steps along the largest and the two largest fractions; ties go to
+	// red, then green, so s1 stays one-hot and s2 two-hot on the grey axis
+	vec3 g = vec3(step(f.g, f.r), step(f.b, f.g), 1.0 - step(f.b, f.r));
+	vec3 l = 1.0 - g;
+	vec3 s1 = min(g, l.brg);
+	vec3 s2 = max(g, l.brg);
+
+	float f1 = dot(f, s1);
+	float f2 = dot(f, s2) - f1;
+	float f3 = f.r + f.g + f.b - f1 - f2;
+
+	return lut_texel(lut, i0, size) * (1.0 - f1)
+	     + lut_texel(lut, i0 + s1, size) * (f1 - f2)
+	     + lut_texel(lut, i0 + s2, size) * (f2 - f3)
+	     + lut_texel(lut, i0 + 1.0, size) * f3;
+}
+
+vec3 lut_nearest_slice(sampler2D lut, vec3 c, float size)
+{
+	c = clamp(c, 0.0, 1.0);
+	float b = floor(c.b * (size - 1.0) + 0.5);
+	return texture(lut, vec2(b / size, 0.0) + lut_rg_coord(c, size)).rgb;
+}
+
+vec3 lut_sample(sampler2D lut, vec3 c, float size, float mode)
+{
+	if (mode > 1.5)
+		return lut_nearest_slice(lut, c, size);
+	if (mode > 0.5)
+		return lut_tetrahedral(lut, c, size);
+	return lut_trilinear(lut, c, size);
+}
+
+#endif
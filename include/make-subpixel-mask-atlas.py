@@ -0,0 +1,314 @@
+#!/usr/bin/env python3
+
+"""
+Bakes the phosphor layouts of subpixel_masks.h into subpixel_masks_atlas.png
+and writes subpixel_masks_atlas.h, the lookup which reads it.
+
+The layouts are read from mask_weights() and mask_weights_alpha() themselves,
+so after a layout is added or changed in subpixel_masks.h the atlas and its
+header only need to be regenerated; the two functions must agree on every
+tile. Each layout gets one cell of the atlas, the cells are stacked
+vertically in layout order, and every cell holds the layout's tile at native
+pixel pitch in its top left corner:
+  rgb  subpixel lit (255) or not (0); the mask intensity is applied by the
+       lookup, so one atlas serves every intensity
+  a    255
+The tile sizes and lit fractions (the "alpha" of mask_weights_alpha) go into
+constant arrays in subpixel_masks_atlas.h.
+
+Usage: python3 make-subpixel-mask-atlas.py  (run from this directory)
+"""
+
+import re
+import struct
+import zlib
+
+HEADER = 'subpixel_masks.h'
+ATLAS = 'subpixel_masks_atlas.png'
+ATLAS_HEADER = 'subpixel_masks_atlas.h'
+
+# Tiles are searched for a period up to this size
+MAX_TILE = (16, 8)
+
+
+def function_body(src, name):
+    start = src.index('{', src.index('vec3 %s(' % name))
+    depth = 0
+    for i in range(start, len(src)):
+        depth += {'{': 1, '}': -1}.get(src[i], 0)
+        if depth == 0:
+            return src[start + 1:i]
+    raise ValueError('unterminated function ' + name)
+
+
+def split_blocks(body):
+    """Returns the statements before the first layout and {layout: block}."""
+    heads = list(re.finditer(r'phosphor_layout\s*==\s*(\d+)\s*\)', body))
+    prologue = body[:heads[0].start()]
+    blocks = {}
+    for head in heads:
+        rest = body[head.end():].lstrip()
+        if not rest.startswith('{'):
+            # single statement layout, e.g. "if(phosphor_layout == 0) return weights;"
+            blocks[int(head.group(1))] = rest[:rest.index(';') + 1]
+            continue
+        start = head.end() + body[head.end():].index('{')
+        depth = 0
+        for i in range(start, len(body)):
+            depth += {'{': 1, '}': -1}.get(body[i], 0)
+            if depth == 0:
+                blocks[int(head.group(1))] = body[start + 1:i]
+                break
+    return prologue, blocks
+
+
+def statements(code):
+    code = re.sub(r'//[^\n]*', '', code)
+    return [s.strip() for s in code.split(';') if s.strip()]
+
+
+class Layout:
+    """Evaluates the restricted GLSL the layouts are written in."""
+
+    def __init__(self, colors, globals_):
+        self.colors = colors
+        self.vars = dict(globals_)
+        self.index = {}
+        self.weights = None
+        self.alpha = None
+
+    def expr(self, e, x, y):
+        e = e.strip()
+        m = re.match(r'mix\((.*)\)$', e, re.S)
+        if m:
+            a, b, t = split_args(m.group(1))
+            return select(self.floor_mod(t, x, y), self.expr(a, x, y), self.expr(b, x, y))
+        m = re.match(r'(\w+)((?:\[\w+\])+)$', e)
+        if m:
+            value = self.vars[m.group(1)]
+            for idx in re.findall(r'\[(\w+)\]', m.group(2)):
+                value = value[self.index_value(idx, x, y)]
+            return value
+        if e in self.colors:
+            return self.colors[e]
+        value = self.vars[e]
+        return value(x, y) if callable(value) else value
+
+    def floor_mod(self, t, x, y):
+        m = re.match(r'floor\(mod\(coord\.([xy]),\s*([\d.]+)\)\)$', t.strip())
+        axis, period = m.group(1), int(float(m.group(2)))
+        return (x if axis == 'x' else y) % period
+
+    def index_value(self, idx, x, y):
+        axis, period = self.index[idx]
+        return (x if axis == 'x' else y) % period
+
+    def run(self, code, x, y):
+        for s in statements(code):
+            if s.startswith('return'):
+                break
+            m = re.match(r'vec3\s+(\w+)\s*(?:\[\d+\])+\s*=\s*(?:vec3\[\]\((.*)\)|(\{.*\}))$', s, re.S)
+            if m:
+                self.vars[m.group(1)] = parse_array(m.group(2) or m.group(3), self.colors)
+                continue
+            m = re.match(r'vec3\s+(\w+)\s*=\s*(.*)$', s, re.S)
+            if m:
+                self.vars[m.group(1)] = self.expr(m.group(2), x, y)
+                continue
+            m = re.match(r'(\w+)\s*=\s*int\(floor\(mod\(coord\.([xy]),\s*([\d.]+)\)\)\)$', s)
+            if m:
+                self.index[m.group(1)] = (m.group(2), int(float(m.group(3))))
+                continue
+            m = re.match(r'weights(?:\.rgb)?\s*=\s*(.*)$', s, re.S)
+            if m:
+                self.weights = self.expr(m.group(1), x, y)
+                continue
+            m = re.match(r'alpha\s*=\s*([\d./ ]+)$', s)
+            if m:
+                self.alpha = eval(m.group(1))
+                continue
+            if s.startswith('else') or s.startswith('if'):
+                continue
+            raise ValueError('unsupported statement: ' + s)
+
+
+def split_args(args):
+    out, depth, cur = [], 0, ''
+    for c in args:
+        if c == ',' and depth == 0:
+            out.append(cur)
+            cur = ''
+            continue
+        depth += {'(': 1, ')': -1}.get(c, 0)
+        cur += c
+    return out + [cur]
+
+
+def select(t, a, b):
+    return b if t else a
+
+
+def parse_array(text, colors):
+    text = text.strip()
+    if text.startswith('{'):
+        rows = re.findall(r'\{([^{}]*)\}', text)
+        return [[colors[n.strip()] for n in row.split(',') if n.strip()] for row in rows]
+    return [colors[n.strip()] for n in text.split(',') if n.strip()]
+
+
+def read_colors(prologue):
+    colors = {}
+    for name, args in re.findall(r'vec3\s+(\w+)\s*=\s*vec3\(([^)]*)\)', prologue):
+        colors[name] = tuple(1 if a.strip() == 'on' else 0 for a in args.split(','))
+    return colors
+
+
+def read_layouts(src, name):
+    prologue, blocks = split_blocks(function_body(src, name))
+    colors = read_colors(prologue)
+    globals_ = {}
+    for s in statements(prologue):
+        m = re.match(r'vec3\s+(\w+)\s*=\s*(mix\(.*\))$', s, re.S)
+        if m:
+            expr = m.group(2)
+            globals_[m.group(1)] = lambda x, y, expr=expr: Layout(colors, {}).expr(expr, x, y)
+
+    layouts = {}
+    for n, block in sorted(blocks.items()):
+        grid = []
+        alpha = 1.0
+        for y in range(2 * MAX_TILE[1]):
+            row = []
+            for x in range(2 * MAX_TILE[0]):
+                layout = Layout(colors, globals_)
+                layout.run(block, x, y)
+                row.append(layout.weights if layout.weights is not None else (1, 1, 1))
+                if layout.alpha is not None:
+                    alpha = layout.alpha
+            grid.append(row)
+        layouts[n] = (tile_of(grid, n), alpha)
+    return layouts
+
+
+def tile_of(grid, n):
+    for h in range(1, MAX_TILE[1] + 1):
+        for w in range(1, MAX_TILE[0] + 1):
+            if all(grid[y][x] == grid[y % h][x % w]
+                   for y in range(len(grid)) for x in range(len(grid[0]))):
+                return [row[:w] for row in grid[:h]]
+    raise ValueError('layout %d does not tile within %dx%d' % (n, MAX_TILE[0], MAX_TILE[1]))
+
+
+def write_png(path, width, rows):
+    raw = b''.join(b'\x00' + bytes(row) for row in rows)
+
+    def chunk(tag, data):
+        return struct.pack('>I', len(data)) + tag + data + struct.pack('>I', zlib.crc32(tag + data) & 0xffffffff)
+
+    with open(path, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', width, len(rows), 8, 6, 0, 0, 0)))
+        f.write(chunk(b'IDAT', zlib.compress(raw, 9)))
+        f.write(chunk(b'IEND', b''))
+
+
+def fraction(value):
+    for den in range(1, 257):
+        num = round(value * den)
+        if abs(num / den - value) < 1e-9:
+            return '%d.0/%d.0' % (num, den)
+    return repr(value)
+
+
+def write_header(path, layouts, cell):
+    count = len(layouts)
+    tiles = ', '.join('ivec2(%d, %d)' % (len(t[0]), len(t)) for t, _ in layouts)
+    lit = ', '.join(fraction(a) for _, a in layouts)
+    with open(path, 'w') as f:
+        f.write('''/*
+Generated by make-subpixel-mask-atlas.py from subpixel_masks.h, do not edit.
+
+Texture lookup version of mask_weights() and mask_weights_alpha(). Every
+phosphor layout is baked into subpixel_masks_atlas.png at native pixel pitch,
+so the mask costs one texelFetch instead of a branch per layout and an array
+built per pixel.
+
+How to use it:
+
+Declare the atlas before including this file, with a binding free in the
+shader, and add it to the preset's textures with filtering off:
+layout(set = 0, binding = N) uniform sampler2D SubpixelMaskAtlas;
+SubpixelMaskAtlas = ".../include/subpixel_masks_atlas.png"
+SubpixelMaskAtlas_linear = false
+
+then multiply your image by the vec3 output, with the same coord, layout and
+intensity as mask_weights():
+FragColor.rgb *= mask_atlas_weights(gl_FragCoord.xy, 1, 1.0);
+
+Layouts outside 0..%d give no mask, like mask_weights().
+*/
+
+#define SUBPIXEL_MASK_LAYOUTS %d
+
+// Size of a layout's cell in the atlas; cells are stacked vertically
+const ivec2 SUBPIXEL_MASK_CELL = ivec2(%d, %d);
+
+// Tile size of each layout
+const ivec2 SUBPIXEL_MASK_TILE[SUBPIXEL_MASK_LAYOUTS] = ivec2[](
+   %s);
+
+// Lit subpixels per subpixel of each layout, the alpha of mask_weights_alpha()
+const float SUBPIXEL_MASK_LIT[SUBPIXEL_MASK_LAYOUTS] = float[](
+   %s);
+
+vec3 mask_atlas_weights(vec2 coord, int phosphor_layout, float mask_intensity){
+   int index = (phosphor_layout >= 0 && phosphor_layout < SUBPIXEL_MASK_LAYOUTS) ? phosphor_layout : 0;
+   ivec2 tile = SUBPIXEL_MASK_TILE[index];
+   ivec2 texel = ivec2(mod(floor(coord), vec2(tile))) + ivec2(0, index * SUBPIXEL_MASK_CELL.y);
+   vec3 lit = texelFetch(SubpixelMaskAtlas, texel, 0).rgb;
+   return mix(vec3(1. - mask_intensity), vec3(1.), lit);
+}
+
+vec3 mask_atlas_weights_alpha(vec2 coord, int phosphor_layout, float mask_intensity, out float alpha){
+   int index = (phosphor_layout >= 0 && phosphor_layout < SUBPIXEL_MASK_LAYOUTS) ? phosphor_layout : 0;
+   alpha = SUBPIXEL_MASK_LIT[index];
+   return mask_atlas_weights(coord, index, mask_intensity);
+}
+''' % (count - 1, count, cell[0], cell[1],
+       wrap(tiles, 'ivec2('), wrap(lit, None)))
+
+
+def wrap(items, lead):
+    parts = [p.strip() for p in (re.split(r',\s*(?=ivec2\()', items) if lead else items.split(','))]
+    lines, cur = [], ''
+    for p in parts:
+        if cur and len(cur) + len(p) + 2 > 72:
+            lines.append(cur + ',')
+            cur = ''
+        cur = (cur + ', ' + p) if cur else p
+    lines.append(cur)
+    return '\n   '.join(lines)
+
+
+if __name__ == '__main__':
+    with open(HEADER) as f:
+        src = f.read()
+    plain = read_layouts(src, 'mask_weights')
+    with_alpha = read_layouts(src, 'mask_weights_alpha')
+    assert sorted(plain) == list(range(len(plain))), 'layouts are not numbered 0..n'
+    for n in plain:
+        assert plain[n][0] == with_alpha[n][0], \
+            'layout %d differs between mask_weights and mask_weights_alpha' % n
+
+    layouts = [(plain[n][0], with_alpha[n][1]) for n in sorted(plain)]
+    cell = (max(len(t[0]) for t, _ in layouts), max(len(t) for t, _ in layouts))
+    rows = []
+    for tile, _ in layouts:
+        for y in range(cell[1]):
+            row = []
+            for x in range(cell[0]):
+                lit = tile[y][x] if y < len(tile) and x < len(tile[0]) else (0, 0, 0)
+                row += [255 * c for c in lit] + [255]
+            rows.append(row)
+    write_png(ATLAS, cell[0], rows)
+    write_header(ATLAS_HEADER, layouts, cell)
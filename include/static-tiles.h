@@ -0,0 +1,39 @@
+#ifndef STATIC_TILES_H
+#define STATIC_TILES_H
+
+//  Static-frame reuse. misc/shaders/static-tiles.slang passes its Source
+//  through and, in the alpha of the texels in its top left corner, flags
+//  each STATIC_TILE_SIZE square of Original that did not change since the
+//  last frame, the STATIC_MARGIN texels around it included. Alias that
+//  pass StaticTiles. A later pass whose footprint in Original fits within
+//  the margin can then copy its own output of the last frame over the
+//  static tiles instead of recomputing it:
+//      layout(set = 0, binding = 4) uniform sampler2D StaticTiles;
+//      layout(set = 0, binding = 5) uniform sampler2D scalefx_pass3Feedback;
+//      ...
+//      if (static_tile(StaticTiles, scalefx_pass3Feedback, vTexCoord, params.OutputSize.xy))
+//      {
+//          FragColor = texelFetch(scalefx_pass3Feedback, ivec2(gl_FragCoord.xy), 0);
+//          return;
+//      }
+//  The pass must be aliased for its Feedback texture to exist, and should
+//  not be the last one, which renders to the screen.
+
+#define STATIC_TILE_SIZE 8
+
+//  Tile flags: 1.0 static, 0.5 changed, 0.0 never written
+#define STATIC_TILE_STATIC  1.0
+#define STATIC_TILE_CHANGED 0.5
+
+bool static_tile(sampler2D tiles, sampler2D feedback, vec2 coord, vec2 output_size)
+{
+    //  a resized output has no last frame to reuse
+    if (textureSize(feedback, 0) != ivec2(output_size))
+        return false;
+
+    ivec2 size = textureSize(tiles, 0);
+    ivec2 texel = min(ivec2(coord * vec2(size)), size - 1);
+    return texelFetch(tiles, texel / STATIC_TILE_SIZE, 0).a > 0.75;
+}
+
+#endif  //  STATIC_TILES_H
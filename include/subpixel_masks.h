@@ -26,6 +26,11 @@ layout to apply. 0 is no mask/passthru.
 
 Many of these mask arrays are adapted from cgwg's crt-geom-deluxe LUTs, and
 those have their filenames included for easy identification
+
+subpixel_masks_atlas.h is a texture lookup version of both functions, which
+reads every layout from subpixel_masks_atlas.png. Both are generated from the
+layouts below by make-subpixel-mask-atlas.py, so run it again after adding or
+changing a layout here.
 */
 
 vec3 mask_weights(vec2 coord, float mask_intensity, int phosphor_layout){
@@ -0,0 +1,56 @@
+/*
+Generated by make-subpixel-mask-atlas.py from subpixel_masks.h, do not edit.
+
+Texture lookup version of mask_weights() and mask_weights_alpha(). Every
+phosphor layout is baked into subpixel_masks_atlas.png at native pixel pitch,
+so the mask costs one texelFetch instead of a branch per layout and an array
+built per pixel.
+
+How to use it:
+
+Declare the atlas before including this file, with a binding free in the
+shader, and add it to the preset's textures with filtering off:
+layout(set = 0, binding = N) uniform sampler2D SubpixelMaskAtlas;
+SubpixelMaskAtlas = ".../include/subpixel_masks_atlas.png"
+SubpixelMaskAtlas_linear = false
+
+then multiply your image by the vec3 output, with the same coord, layout and
+intensity as mask_weights():
+FragColor.rgb *= mask_atlas_weights(gl_FragCoord.xy, 1, 1.0);
+
+Layouts outside 0..24 give no mask, like mask_weights().
+*/
+
+#define SUBPIXEL_MASK_LAYOUTS 25
+
+// Size of a layout's cell in the atlas; cells are stacked vertically
+const ivec2 SUBPIXEL_MASK_CELL = ivec2(14, 6);
+
+// Tile size of each layout
+const ivec2 SUBPIXEL_MASK_TILE[SUBPIXEL_MASK_LAYOUTS] = ivec2[](
+   ivec2(1, 1), ivec2(2, 1), ivec2(2, 2), ivec2(4, 3), ivec2(2, 1),
+   ivec2(2, 2), ivec2(4, 1), ivec2(5, 1), ivec2(7, 1), ivec2(4, 1),
+   ivec2(4, 1), ivec2(4, 2), ivec2(4, 2), ivec2(4, 4), ivec2(6, 3),
+   ivec2(8, 4), ivec2(4, 3), ivec2(10, 4), ivec2(10, 4), ivec2(14, 6),
+   ivec2(4, 4), ivec2(8, 4), ivec2(3, 1), ivec2(4, 1), ivec2(10, 6));
+
+// Lit subpixels per subpixel of each layout, the alpha of mask_weights_alpha()
+const float SUBPIXEL_MASK_LIT[SUBPIXEL_MASK_LAYOUTS] = float[](
+   1.0/1.0, 1.0/2.0, 1.0/2.0, 1.0/3.0, 1.0/2.0, 1.0/2.0, 1.0/4.0, 2.0/5.0,
+   4.0/9.0, 1.0/2.0, 1.0/2.0, 1.0/4.0, 1.0/2.0, 1.0/2.0, 2.0/9.0, 3.0/8.0,
+   7.0/18.0, 3.0/10.0, 3.0/10.0, 89.0/252.0, 3.0/8.0, 7.0/32.0, 2.0/3.0,
+   1.0/2.0, 2.0/5.0);
+
+vec3 mask_atlas_weights(vec2 coord, int phosphor_layout, float mask_intensity){
+   int index = (phosphor_layout >= 0 && phosphor_layout < SUBPIXEL_MASK_LAYOUTS) ? phosphor_layout : 0;
+   ivec2 tile = SUBPIXEL_MASK_TILE[index];
+   ivec2 texel = ivec2(mod(floor(coord), vec2(tile))) + ivec2(0, index * SUBPIXEL_MASK_CELL.y);
+   vec3 lit = texelFetch(SubpixelMaskAtlas, texel, 0).rgb;
+   return mix(vec3(1. - mask_intensity), vec3(1.), lit);
+}
+
+vec3 mask_atlas_weights_alpha(vec2 coord, int phosphor_layout, float mask_intensity, out float alpha){
+   int index = (phosphor_layout >= 0 && phosphor_layout < SUBPIXEL_MASK_LAYOUTS) ? phosphor_layout : 0;
+   alpha = SUBPIXEL_MASK_LIT[index];
+   return mask_atlas_weights(coord, index, mask_intensity);
+}
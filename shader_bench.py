@@ -0,0 +1,436 @@
+#!/usr/bin/env python3
+
+############# Shader Cost Benchmark Script ##############
+# license: public domain
+#  Use this script to record what presets cost and to
+#    catch presets that got more expensive.
+#
+#  The script expects to run from the top-level of
+#    the slang shader repo. Pass presets the same way
+#    as to shader_deploy.py (paths, wildcards or a
+#    *.txt list); without arguments every .slangp in
+#    the repo is measured. For a fixed input size and
+#    output (viewport) size it records per preset:
+#      - passes: number of shader passes
+#      - rt_bytes: bytes of all render targets, with
+#        feedback and OriginalHistory copies counted
+#      - lut_bytes: bytes of the LUT textures
+#      - fetches_per_pixel: texture sampling call sites
+#        in each fragment stage, weighted by the pass
+#        size relative to the viewport. Every branch
+#        counts and loops count once, so this is a
+#        static estimate to compare between commits,
+#        not a measurement.
+#      - ms_per_frame: wall time per frame, only when
+#        --retroarch/--core/--content are given, e.g.
+#        against lavapipe in a headless X server:
+#          VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json \
+#          xvfb-run -a ./shader_bench.py --retroarch retroarch \
+#            --core cores/snes9x_libretro.so --content rom.sfc
+#        The time of nearest.slangp is subtracted.
+#    and writes everything to a JSON manifest.
+#
+#  --compare OLD.json flags presets whose metrics grew
+#    by more than --threshold (default 0.1 = 10%) and
+#    exits with status 2 if there are any, so the
+#    manifest of the previous commit can gate a change.
+#
+##########################################################
+
+import argparse
+import glob
+import json
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+# ------------------------------------------------------------
+# CONFIG
+# ------------------------------------------------------------
+
+REPO_ROOT = Path.cwd()
+DEFAULT_MANIFEST = REPO_ROOT / "shader_cost_manifest.json"
+BASELINE_PRESET = REPO_ROOT / "nearest.slangp"
+
+# key = value lines of a preset, value optionally quoted, trailing comments
+KEY_VALUE_RE = re.compile(r'^\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*"?([^"#\n]*?)"?\s*(?:#.*)?$')
+REFERENCE_RE = re.compile(r'^\s*#reference\s+"([^"]+)"')
+INCLUDE_RE = re.compile(r'^\s*#include\s+"([^"]+)"', re.M)
+FORMAT_RE = re.compile(r'^\s*#pragma\s+format\s+(\w+)', re.M)
+STAGE_RE = re.compile(r'^\s*#pragma\s+stage\s+(\w+)', re.M)
+COMMENT_RE = re.compile(r'//[^\n]*|/\*.*?\*/', re.S)
+FETCH_RE = re.compile(r'\b(?:texture|textureLod|textureGrad|textureOffset|textureLodOffset|textureProj|'
+                      r'textureGather|textureGatherOffset|texelFetch|texelFetchOffset|'
+                      r'tex2D\w*|COMPAT_TEXTURE|COMPAT_Sample|TEX2D)\s*\(')
+FEEDBACK_RE = re.compile(r'\b(\w+?)Feedback\b')
+PASS_FEEDBACK_RE = re.compile(r'\bPassFeedback(\d+)\b')
+HISTORY_RE = re.compile(r'\bOriginalHistory(\d+)\b')
+WILDCARD_RE = re.compile(r'\$[A-Z0-9_\-]+\$')
+
+FORMAT_BYTES = {
+    "R8_UNORM": 1, "R8_UINT": 1, "R8_SINT": 1,
+    "R8G8_UNORM": 2, "R8G8_UINT": 2, "R8G8_SINT": 2,
+    "R8G8B8A8_UNORM": 4, "R8G8B8A8_UINT": 4, "R8G8B8A8_SINT": 4, "R8G8B8A8_SRGB": 4,
+    "A2B10G10R10_UNORM_PACK32": 4, "A2B10G10R10_UINT_PACK32": 4,
+    "R16_UINT": 2, "R16_SINT": 2, "R16_SFLOAT": 2,
+    "R16G16_UINT": 4, "R16G16_SINT": 4, "R16G16_SFLOAT": 4,
+    "R16G16B16A16_UINT": 8, "R16G16B16A16_SINT": 8, "R16G16B16A16_SFLOAT": 8,
+    "R32_UINT": 4, "R32_SINT": 4, "R32_SFLOAT": 4,
+    "R32G32_UINT": 8, "R32G32_SINT": 8, "R32G32_SFLOAT": 8,
+    "R32G32B32A32_UINT": 16, "R32G32B32A32_SINT": 16, "R32G32B32A32_SFLOAT": 16,
+}
+
+METRICS = ("passes", "rt_bytes", "lut_bytes", "fetches_per_pixel", "ms_per_frame")
+
+# ------------------------------------------------------------
+# UTILITY
+# ------------------------------------------------------------
+
+silent = False
+
+def log(msg: str):
+    if not silent:
+        print(msg, file=sys.stderr)
+
+def rel(path: Path) -> str:
+    try:
+        return path.resolve().relative_to(REPO_ROOT.resolve()).as_posix()
+    except ValueError:
+        return str(path)
+
+def resolve_path(base_file: Path, value: str) -> Path:
+    if WILDCARD_RE.search(value):
+        matches = sorted(glob.glob(str(base_file.parent / WILDCARD_RE.sub("*", value))))
+        if matches:
+            return Path(matches[0]).resolve()
+    return (base_file.parent / value).resolve()
+
+def to_bool(value: str) -> bool:
+    return value.strip().lower() in ("true", "1")
+
+def image_bytes(path: Path, mipmap: bool) -> int:
+    """RGBA8 size of a PNG/JPEG LUT, read from its header."""
+    try:
+        with path.open("rb") as f:
+            data = f.read(64 * 1024)
+    except OSError:
+        return 0
+    w = h = 0
+    if data[:8] == b"\x89PNG\r\n\x1a\n":
+        w, h = struct.unpack(">II", data[16:24])
+    elif data[:2] == b"\xff\xd8":
+        i = 2
+        while i + 9 < len(data):
+            if data[i] != 0xFF:
+                i += 1
+                continue
+            marker = data[i + 1]
+            if 0xC0 <= marker <= 0xCF and marker not in (0xC4, 0xC8, 0xCC):
+                h, w = struct.unpack(">HH", data[i + 5:i + 9])
+                break
+            i += 2 + struct.unpack(">H", data[i + 2:i + 4])[0]
+    size = w * h * 4
+    return size * 4 // 3 if mipmap else size
+
+# ------------------------------------------------------------
+# PARSERS
+# ------------------------------------------------------------
+
+source_cache = {}
+
+def expand_source(path: Path, stack=()) -> str:
+    """Shader text with #includes expanded."""
+    if path in source_cache:
+        return source_cache[path]
+    if path in stack or not path.exists():
+        return ""
+    text = path.read_text(encoding="utf-8", errors="ignore")
+    text = INCLUDE_RE.sub(lambda m: expand_source(resolve_path(path, m.group(1)), stack + (path,)), text)
+    source_cache[path] = text
+    return text
+
+def fragment_stage(text: str) -> str:
+    out, stage, pos = [], None, 0
+    for m in STAGE_RE.finditer(text):
+        if stage in (None, "fragment"):
+            out.append(text[pos:m.start()])
+        stage, pos = m.group(1), m.end()
+    if stage in (None, "fragment"):
+        out.append(text[pos:])
+    return "".join(out)
+
+def read_preset(path: Path, stack=()) -> dict:
+    """Flattened key/value settings of a preset; #reference'd files come
+    first and the referencing file overrides them. Values are kept as
+    (value, file) so paths can be resolved against the file setting them."""
+    values = {}
+    if path in stack:
+        raise ValueError(f"circular #reference: {rel(path)}")
+    for line in path.read_text(encoding="utf-8", errors="ignore").splitlines():
+        m = REFERENCE_RE.match(line)
+        if m:
+            values.update(read_preset(resolve_path(path, m.group(1)), stack + (path,)))
+            continue
+        m = KEY_VALUE_RE.match(line)
+        if m:
+            values[m.group(1)] = (m.group(2).strip(), path)
+    return values
+
+def preset_path(values: dict, key: str):
+    if key not in values:
+        return None
+    value, origin = values[key]
+    return resolve_path(origin, value.replace("\\", "/"))
+
+# ------------------------------------------------------------
+# COST MODEL
+# ------------------------------------------------------------
+
+def pass_size(values: dict, i: int, count: int, source, original, viewport):
+    size = []
+    for axis, n in ((0, "x"), (1, "y")):
+        kind = values.get(f"scale_type_{n}{i}", values.get(f"scale_type{i}"))
+        scale = values.get(f"scale_{n}{i}", values.get(f"scale{i}"))
+        if kind is None:
+            kind, scale = ("viewport", 1.0) if i == count - 1 else ("source", 1.0)
+        scale = float(scale) if scale not in (None, "") else 1.0
+        if kind == "absolute":
+            size.append(max(1, int(scale)))
+        elif kind == "viewport":
+            size.append(max(1, round(viewport[axis] * scale)))
+        elif kind == "original":
+            size.append(max(1, round(original[axis] * scale)))
+        else:
+            size.append(max(1, round(source[axis] * scale)))
+    return tuple(size)
+
+shader_cache = {}
+
+def shader_info(path: Path) -> dict:
+    """What the cost model needs from one shader, cached per file."""
+    if path not in shader_cache:
+        text = COMMENT_RE.sub("", expand_source(path))
+        frag = fragment_stage(text)
+        fmt = FORMAT_RE.search(text)
+        name = re.search(r"^\s*#pragma\s+name\s+(\w+)", text, re.M)
+        shader_cache[path] = {
+            "format": fmt.group(1) if fmt else None,
+            "name": name.group(1) if name else None,
+            "fetches": len(FETCH_RE.findall(frag)),
+            "feedback": set(FEEDBACK_RE.findall(frag)),
+            "pass_feedback": {int(n) for n in PASS_FEEDBACK_RE.findall(frag)},
+            "history": max([0] + [int(n) for n in HISTORY_RE.findall(frag)]),
+        }
+    return shader_cache[path]
+
+def measure_preset(preset: Path, original, viewport) -> dict:
+    settings = read_preset(preset)
+    values = {key: value for key, (value, _) in settings.items()}
+    count = int(values.get("shaders", 0))
+    missing = []
+    passes, aliases, infos = [], {}, []
+    source = original
+    for i in range(count):
+        shader = preset_path(settings, f"shader{i}")
+        if shader and shader.exists():
+            info = shader_info(shader)
+        else:
+            missing.append(rel(shader) if shader else f"shader{i}")
+            info = {"format": None, "name": None, "fetches": 0, "feedback": set(),
+                    "pass_feedback": set(), "history": 0}
+        infos.append(info)
+        size = pass_size(values, i, count, source, original, viewport)
+        fmt = info["format"]
+        if not fmt:
+            fmt = "R16G16B16A16_SFLOAT" if to_bool(values.get(f"float_framebuffer{i}", "false")) else "R8G8B8A8_UNORM"
+        alias = values.get(f"alias{i}") or info["name"]
+        if alias:
+            aliases[alias] = i
+        passes.append({"size": size, "bytes": size[0] * size[1] * FORMAT_BYTES.get(fmt, 4)})
+        source = size
+
+    # feedback keeps a second copy of a pass, OriginalHistory keeps old inputs
+    feedback, history = set(), 0
+    for info in infos:
+        feedback.update(aliases[n] for n in info["feedback"] if n in aliases)
+        feedback.update(n for n in info["pass_feedback"] if n < count)
+        history = max(history, info["history"])
+
+    # the last pass renders to the backbuffer
+    rt_bytes = sum(p["bytes"] for p in passes[:-1])
+    rt_bytes += sum(passes[i]["bytes"] for i in feedback)
+    rt_bytes += history * original[0] * original[1] * 4
+
+    viewport_pixels = viewport[0] * viewport[1]
+    fetches = sum(info["fetches"] * p["size"][0] * p["size"][1]
+                  for info, p in zip(infos, passes)) / viewport_pixels
+
+    textures = [t.strip() for t in values.get("textures", "").split(";") if t.strip()]
+    lut_bytes = 0
+    for name in textures:
+        path = preset_path(settings, name)
+        if path and path.exists():
+            lut_bytes += image_bytes(path, to_bool(values.get(f"{name}_mipmap", "false")))
+        else:
+            missing.append(name)
+
+    result = {
+        "passes": count,
+        "rt_bytes": rt_bytes,
+        "lut_bytes": lut_bytes,
+        "fetches_per_pixel": round(fetches, 3),
+        "ms_per_frame": None,
+    }
+    if missing:
+        result["missing"] = missing
+    return result
+
+# ------------------------------------------------------------
+# TIMING
+# ------------------------------------------------------------
+
+def time_preset(args, preset: Path, viewport):
+    """Seconds RetroArch needs for args.frames frames with the preset."""
+    with tempfile.NamedTemporaryFile("w", suffix=".cfg", delete=False) as cfg:
+        cfg.write(
+            'video_driver = "vulkan"\n'
+            'video_vsync = "false"\n'
+            'video_fullscreen = "false"\n'
+            'video_window_save_positions = "true"\n'
+            f'window_position_width = "{viewport[0]}"\n'
+            f'window_position_height = "{viewport[1]}"\n'
+            'video_scale_integer = "false"\n'
+            'audio_driver = "null"\n'
+            'pause_nonactive = "false"\n'
+            'video_shader_enable = "true"\n')
+    cmd = [args.retroarch, "--appendconfig", cfg.name, f"--max-frames={args.frames}",
+           "--set-shader", str(preset), "-L", args.core, args.content]
+    try:
+        start = time.perf_counter()
+        subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                       timeout=args.timeout, check=True)
+        return time.perf_counter() - start
+    except (subprocess.SubprocessError, OSError):
+        return None
+    finally:
+        os.unlink(cfg.name)
+
+# ------------------------------------------------------------
+# INPUT EXPANSION
+# ------------------------------------------------------------
+
+def expand_inputs(args: list[str]) -> list[Path]:
+    if not args:
+        return sorted(p.resolve() for p in REPO_ROOT.rglob("*.slangp") if ".git" not in p.parts)
+    out = []
+    for a in args:
+        p = Path(a)
+        if p.is_file() and p.suffix.lower() == ".txt":
+            lines = [l.strip() for l in p.read_text().splitlines()]
+            out.extend(expand_inputs([l for l in lines if l and not l.startswith("#")]))
+            continue
+        matches = glob.glob(a, recursive=True)
+        out.extend(Path(m).resolve() for m in (matches or [a]))
+    return out
+
+# ------------------------------------------------------------
+# COMPARISON
+# ------------------------------------------------------------
+
+def compare(old: dict, new: dict, threshold: float) -> list[str]:
+    report = []
+    for preset, cost in sorted(new["presets"].items()):
+        before = old.get("presets", {}).get(preset)
+        if not before:
+            continue
+        for metric in METRICS:
+            a, b = before.get(metric), cost.get(metric)
+            if a is None or b is None:
+                continue
+            if b > a * (1.0 + threshold) and b - a > 1e-6:
+                report.append(f"{preset}: {metric} {a} -> {b}")
+    return report
+
+# ------------------------------------------------------------
+# MAIN
+# ------------------------------------------------------------
+
+def main():
+    global silent
+    parser = argparse.ArgumentParser(description="Record the cost of slang presets.")
+    parser.add_argument("presets", nargs="*", help="presets, wildcards or a *.txt list (default: all)")
+    parser.add_argument("--input", default="320x240", help="input (Original) size, default 320x240")
+    parser.add_argument("--output", default="1280x960", help="output (viewport) size, default 1280x960")
+    parser.add_argument("--manifest", default=str(DEFAULT_MANIFEST), help="manifest to write")
+    parser.add_argument("--compare", help="manifest of a previous commit to check against")
+    parser.add_argument("--threshold", type=float, default=0.1, help="relative growth flagged by --compare")
+    parser.add_argument("--retroarch", help="RetroArch binary, enables timing")
+    parser.add_argument("--core", help="libretro core used for timing")
+    parser.add_argument("--content", help="content loaded by the core for timing")
+    parser.add_argument("--frames", type=int, default=300, help="frames per timing run")
+    parser.add_argument("--timeout", type=float, default=120.0, help="seconds before a timing run is abandoned")
+    parser.add_argument("--silent", action="store_true")
+    args = parser.parse_args()
+    silent = args.silent
+
+    original = tuple(int(v) for v in args.input.lower().split("x"))
+    viewport = tuple(int(v) for v in args.output.lower().split("x"))
+    timing = bool(args.retroarch and args.core and args.content)
+
+    baseline = None
+    if timing:
+        baseline = time_preset(args, BASELINE_PRESET.resolve(), viewport)
+        if baseline is None:
+            sys.exit("shader_bench: the baseline timing run failed")
+
+    presets = {}
+    for preset in expand_inputs(args.presets):
+        name = rel(preset)
+        try:
+            cost = measure_preset(preset, original, viewport)
+        except (OSError, ValueError) as e:
+            log(f"WARNING: {name}: {e}")
+            continue
+        if timing:
+            elapsed = time_preset(args, preset, viewport)
+            if elapsed is not None:
+                cost["ms_per_frame"] = round(max(0.0, elapsed - baseline) * 1000.0 / args.frames, 3)
+        presets[name] = cost
+        log(f"{name}: {cost['passes']} passes, {cost['rt_bytes']} RT bytes, "
+            f"{cost['fetches_per_pixel']} fetches/px")
+
+    try:
+        commit = subprocess.run(["git", "rev-parse", "HEAD"], capture_output=True,
+                                text=True, cwd=REPO_ROOT).stdout.strip() or None
+    except OSError:
+        commit = None
+    manifest = {
+        "commit": commit,
+        "input": list(original),
+        "output": list(viewport),
+        "frames": args.frames if timing else None,
+        "presets": presets,
+    }
+    with open(args.manifest, "w", encoding="utf-8") as f:
+        json.dump(manifest, f, indent=1, sort_keys=True)
+        f.write("\n")
+    log(f"Manifest written to {args.manifest}")
+
+    if args.compare:
+        with open(args.compare, encoding="utf-8") as f:
+            old = json.load(f)
+        if (old.get("input"), old.get("output")) != (manifest["input"], manifest["output"]):
+            log("WARNING: the manifests were measured at different sizes")
+        regressions = compare(old, manifest, args.threshold)
+        for line in regressions:
+            print(f"REGRESSION: {line}")
+        if regressions:
+            sys.exit(2)
+
+if __name__ == "__main__":
+    main()
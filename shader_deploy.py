@@ -22,13 +22,29 @@
 #    the dependency tree to a text file using the
 #    --LogToFile switch.
 #
+#  The references, shaders, includes and LUTs of
+#    every file are kept in '.shader_deploy_index.json'
+#    together with the file's size, mtime and content
+#    hash, so only files that changed since the last
+#    run are parsed again, in parallel (--jobs N).
+#    --dry-run prints the files each preset needs as
+#    JSON instead of copying them, and --check indexes
+#    every preset in the repo and reports missing files
+#    and circular references; it exits with status 2
+#    if there are any.
+#
 #####################################################
 
+import concurrent.futures
+import functools
+import glob
+import hashlib
+import json
+import os
+import re
 import shutil
 import sys
-import re
 from pathlib import Path
-import glob
 
 # ------------------------------------------------------------
 # CONFIG
@@ -37,6 +53,11 @@ import glob
 REPO_ROOT = Path.cwd()
 EXPORT_ROOT = REPO_ROOT / "shader_export"
 DEPENDENCY_TREE_FILE = REPO_ROOT / "export_log.txt"
+INDEX_FILE = REPO_ROOT / ".shader_deploy_index.json"
+ROOT = os.path.normpath(str(REPO_ROOT.resolve()))
+
+# Bump when the parsers change, so old indexes are thrown away
+INDEX_VERSION = 1
 
 # Standard shader entries inside .slangp
 SHADER_RE = re.compile(r'^\s*shader\d+\s*=\s*(.+)$')
@@ -54,6 +75,12 @@ LUT_BARE_RE = re.compile(r'=\s*([^\s]+\.(?:png|jpg))', re.IGNORECASE)
 # Wildcards like $CORE-REQ-ROT$
 WILDCARD_RE = re.compile(r'\$[A-Z0-9_\-]+\$')
 
+PRESET_SUFFIXES = {".slangp", ".params"}
+SHADER_SUFFIXES = {".slang", ".inc", ".h"}
+
+# Below this many stale files the process pool costs more than it saves
+PARALLEL_MIN_FILES = 64
+
 # ------------------------------------------------------------
 # GLOBAL STATE
 # ------------------------------------------------------------
@@ -63,6 +90,9 @@ active_stack = []
 LogToFile = False
 silent = False
 dependency_tree_lines = []
+index = {}
+missing = set()
+circular = set()
 
 # ------------------------------------------------------------
 # UTILITY
@@ -84,7 +114,21 @@ def normalize_relative_path(path: Path) -> Path:
     except ValueError:
         return Path(path.name)
 
-def copy_file(src: Path):
+def index_key(path: str) -> str:
+    rel = os.path.relpath(path, ROOT)
+    return Path(rel).as_posix() if not rel.startswith("..") else path
+
+def normalize(path) -> str:
+    """Absolute path without '..'; cheaper than Path.resolve(), which the
+    walk would otherwise spend most of its time in."""
+    return os.path.normpath(os.path.abspath(str(path)))
+
+@functools.lru_cache(maxsize=None)
+def is_file(path: str) -> bool:
+    return os.path.isfile(path)
+
+def copy_file(src):
+    src = Path(src)
     rel = normalize_relative_path(src)
     dst = EXPORT_ROOT / rel
     dst.parent.mkdir(parents=True, exist_ok=True)
@@ -92,118 +136,224 @@ def copy_file(src: Path):
         shutil.copy2(src, dst)
         log(f"COPIED: {rel}")
 
-def resolve_reference(base_file: Path, relative: str) -> Path:
-    return (base_file.parent / relative).resolve()
+def resolve_reference(base_file: str, relative: str) -> str:
+    # RetroArch accepts Windows separators in presets on every platform
+    return os.path.normpath(os.path.join(os.path.dirname(base_file), relative.replace("\\", "/")))
 
-def handle_wildcard_path(p: str) -> list[str]:
+def handle_wildcard_path(base_file: str, p: str) -> list[str]:
+    """RetroArch replaces the wildcards when it loads the preset, so every
+    file the pattern can match next to the preset is a dependency."""
     if WILDCARD_RE.search(p):
         g = WILDCARD_RE.sub("*", p)
-        return glob.glob(str(REPO_ROOT / g), recursive=True)
-    return [p]
+        return sorted(glob.glob(resolve_reference(base_file, g)))
+    return [resolve_reference(base_file, p)]
 
 # ------------------------------------------------------------
 # PARSERS
 # ------------------------------------------------------------
 
-def parse_shader_file(path: Path, indent: int):
+def parse_shader_file(text: str) -> list:
     """
     Parse .slang, .inc, .h for #include statements.
     """
-    with path.open("r", encoding="utf-8", errors="ignore") as f:
-        for line in f:
-            m = INCLUDE_RE.match(line)
-            if m:
-                inc_rel = clean_path(m.group(1))
-                inc_path = resolve_reference(path, inc_rel)
-                log(f"{'  '*indent}INCLUDE: {inc_path.relative_to(REPO_ROOT)}")
-                if LogToFile:
-                    dependency_tree_lines.append(f"{'  '*indent}INCLUDE: {inc_path.relative_to(REPO_ROOT)}")
-                process_file(inc_path, indent+1)
-
-def parse_presetlike_file(path: Path, indent: int):
+    edges = []
+    for line in text.splitlines():
+        m = INCLUDE_RE.match(line)
+        if m:
+            edges.append(("INCLUDE", clean_path(m.group(1))))
+    return edges
+
+def parse_presetlike_file(text: str, is_slangp: bool) -> list:
     """
     Parse both .slangp and .params files.
     """
-    is_slangp = (path.suffix == ".slangp")
-    with path.open("r", encoding="utf-8", errors="ignore") as f:
-        for line in f:
-
-            # --- #reference "path/to/preset" ---
-            m = REFERENCE_RE.match(line)
+    edges = []
+    for line in text.splitlines():
+
+        # --- #reference "path/to/preset" ---
+        m = REFERENCE_RE.match(line)
+        if m:
+            edges.append(("REFERENCE", clean_path(m.group(1))))
+            continue
+
+        # --- shaderN = X (only in .slangp) ---
+        if is_slangp:
+            m = SHADER_RE.match(line)
             if m:
-                ref_rel = clean_path(m.group(1))
-                ref_abs = resolve_reference(path, ref_rel)
-                log(f"{'  '*indent}REFERENCE: {ref_abs.relative_to(REPO_ROOT)}")
-                if LogToFile:
-                    dependency_tree_lines.append(f"{'  '*indent}REFERENCE: {ref_abs.relative_to(REPO_ROOT)}")
-                process_file(ref_abs, indent+1)
+                edges.append(("SHADER", clean_path(m.group(1).strip())))
                 continue
 
-            # --- shaderN = X (only in .slangp) ---
-            if is_slangp:
-                m = SHADER_RE.match(line)
-                if m:
-                    raw = clean_path(m.group(1).strip())
-                    for expanded in handle_wildcard_path(raw):
-                        ref_abs = resolve_reference(path, expanded)
-                        log(f"{'  '*indent}SHADER: {ref_abs.relative_to(REPO_ROOT)}")
-                        if LogToFile:
-                            dependency_tree_lines.append(f"{'  '*indent}SHADER: {ref_abs.relative_to(REPO_ROOT)}")
-                        process_file(ref_abs, indent+1)
-                    continue
-
-            # --- LUTs (png/jpg only) ---
-            for img in LUT_QUOTED_RE.findall(line):
-                lut_path = resolve_reference(path, clean_path(img))
-                if lut_path.exists():
-                    copy_file(lut_path)
-            m = LUT_BARE_RE.search(line)
-            if m:
-                lut_path = resolve_reference(path, clean_path(m.group(1)))
-                if lut_path.exists():
-                    copy_file(lut_path)
+        # --- LUTs (png/jpg only) ---
+        for img in LUT_QUOTED_RE.findall(line):
+            edges.append(("LUT", clean_path(img)))
+        m = LUT_BARE_RE.search(line)
+        if m:
+            edges.append(("LUT", clean_path(m.group(1))))
+    return edges
+
+def parse_file(job):
+    """
+    Index entry of one file, run in the worker processes. The file is only
+    parsed again when its content hash differs from the cached one.
+    """
+    path, cached_hash = job
+    try:
+        st = os.stat(path)
+        with open(path, "rb") as f:
+            data = f.read()
+    except OSError:
+        return path, None
+    digest = hashlib.sha1(data).hexdigest()
+    entry = {"size": st.st_size, "mtime": st.st_mtime_ns, "hash": digest}
+    if digest == cached_hash:
+        return path, entry
+    suffix = Path(path).suffix
+    text = data.decode("utf-8", errors="ignore")
+    if suffix in PRESET_SUFFIXES:
+        entry["edges"] = parse_presetlike_file(text, suffix == ".slangp")
+    elif suffix in SHADER_SUFFIXES:
+        entry["edges"] = parse_shader_file(text)
+    else:
+        entry["edges"] = []  # images or data
+    return path, entry
+
+# ------------------------------------------------------------
+# INDEX
+# ------------------------------------------------------------
+
+def load_index():
+    global index
+    try:
+        with INDEX_FILE.open("r", encoding="utf-8") as f:
+            data = json.load(f)
+        if data.get("version") == INDEX_VERSION:
+            index = data["files"]
+    except (OSError, ValueError, KeyError):
+        index = {}
+
+def save_index():
+    tmp = INDEX_FILE.with_suffix(".tmp")
+    with tmp.open("w", encoding="utf-8") as f:
+        json.dump({"version": INDEX_VERSION, "files": index}, f, separators=(",", ":"))
+    os.replace(tmp, INDEX_FILE)
+
+def refresh(paths: list[str], jobs: int) -> None:
+    """Bring the index entries of paths up to date."""
+    stale = []
+    for path in paths:
+        key = index_key(path)
+        entry = index.get(key)
+        try:
+            st = os.stat(path)
+        except OSError:
+            index.pop(key, None)
+            continue
+        if entry and entry["size"] == st.st_size and entry["mtime"] == st.st_mtime_ns:
+            continue
+        stale.append((path, entry["hash"] if entry else None))
+    if not stale:
+        return
+    if jobs > 1 and len(stale) >= PARALLEL_MIN_FILES:
+        with concurrent.futures.ProcessPoolExecutor(max_workers=jobs) as pool:
+            results = list(pool.map(parse_file, stale, chunksize=16))
+    else:
+        results = [parse_file(job) for job in stale]
+    for path, entry in results:
+        key = index_key(path)
+        if entry is None:
+            index.pop(key, None)
+            continue
+        if "edges" not in entry:
+            entry["edges"] = index[key]["edges"]  # same content, new mtime
+        index[key] = entry
+
+@functools.lru_cache(maxsize=None)
+def dependencies(path: str) -> tuple:
+    """(kind, path) of every file path refers to, wildcards expanded. Only
+    valid once the index is up to date for path."""
+    out = []
+    for kind, target in index.get(index_key(path), {}).get("edges", []):
+        for resolved in handle_wildcard_path(path, target):
+            out.append((kind, resolved))
+    return tuple(out)
+
+def build_index(roots: list[str], jobs: int) -> None:
+    """Refresh the whole closure of roots, one dependency level at a time so
+    each level is parsed in parallel."""
+    seen = set()
+    level = roots
+    while level:
+        level = [p for p in dict.fromkeys(level) if p not in seen and is_file(p)]
+        seen.update(level)
+        refresh(level, jobs)
+        level = [dep for p in level for _, dep in dependencies(p) if dep not in seen]
 
 # ------------------------------------------------------------
 # CORE DISPATCH
 # ------------------------------------------------------------
 
-def process_file(path: Path, indent: int = 0):
-    path = path.resolve()
+def process_file(path: str, indent: int = 0, kind: str = None, closure: dict = None):
+    rel = index_key(path)
+
+    if kind:
+        log(f"{'  '*(indent-1)}{kind}: {rel}")
+        if LogToFile:
+            dependency_tree_lines.append(f"{'  '*(indent-1)}{kind}: {rel}")
 
-    if path.is_dir():
+    if os.path.isdir(path):
         return  # skip directories
 
-    if not path.exists():
+    if not is_file(path):
         log(f"WARNING: Missing file: {path}")
+        missing.add(rel)
+        if closure is not None:
+            closure["missing"].append(rel)
         return
 
     if path in active_stack:
         log(f"WARNING: Circular reference/include detected: {path}")
+        circular.add(rel)
+        if closure is not None:
+            closure["circular"].append(rel)
         return
 
-    if path in processed:
+    if closure is not None:
+        if rel in closure["seen"]:
+            return
+        closure["seen"].add(rel)
+        closure["files"].append(rel)
+    elif path in processed:
         return
 
     active_stack.append(path)
-    copy_file(path)
 
     # Log starting message for presets
     if indent == 0:
-        log(f"PROCESSING PRESET: {path.relative_to(REPO_ROOT)}")
+        log(f"PROCESSING PRESET: {rel}")
         if LogToFile:
-            dependency_tree_lines.append(f"PRESET: {path.relative_to(REPO_ROOT)}")
+            dependency_tree_lines.append(f"PRESET: {rel}")
 
-    # Dispatch parser
-    if path.suffix in {".slangp", ".params"}:
-        parse_presetlike_file(path, indent)
-    elif path.suffix in {".slang", ".inc", ".h"}:
-        parse_shader_file(path, indent)
-    else:
-        pass  # images or data
+    for dep_kind, dep in dependencies(path):
+        # the LUT patterns also match text that is no file, so these are
+        # skipped quietly, as before
+        if dep_kind == "LUT" and not is_file(dep):
+            continue
+        process_file(dep, indent+1, dep_kind if dep_kind != "LUT" else None, closure)
 
     processed.add(path)
     active_stack.pop()
 
+def closure_of(preset: str) -> dict:
+    closure = {"files": [], "missing": [], "circular": [], "seen": set()}
+    process_file(preset, closure=closure)
+    del closure["seen"]
+    return closure
+
+def export(files: set, jobs: int):
+    EXPORT_ROOT.mkdir(exist_ok=True)
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as pool:
+        list(pool.map(copy_file, sorted(files)))
+
 # ------------------------------------------------------------
 # INPUT EXPANSION
 # ------------------------------------------------------------
@@ -218,18 +368,18 @@ def load_targets_from_file(txt_path: Path) -> list[str]:
             items.append(line)
     return items
 
-def expand_input_arg(arg: str) -> list[Path]:
+def expand_input_arg(arg: str) -> list[str]:
     p = Path(arg)
     if p.exists() and p.is_file() and p.suffix.lower() == ".txt":
         paths = load_targets_from_file(p)
         return expand_preset_inputs(paths)
     matches = glob.glob(arg, recursive=True)
     if matches:
-        return [Path(m).resolve() for m in matches]
+        return [normalize(m) for m in matches]
     else:
-        return [Path(arg).resolve()]
+        return [normalize(arg)]
 
-def expand_preset_inputs(args: list[str]) -> list[Path]:
+def expand_preset_inputs(args: list[str]) -> list[str]:
     out = []
     for a in args:
         out.extend(expand_input_arg(a))
@@ -241,25 +391,58 @@ def expand_preset_inputs(args: list[str]) -> list[Path]:
 
 def main():
     global LogToFile, silent
+    usage = ("Usage: shader_deploy.py [--LogToFile] [--silent] [--dry-run] [--jobs N] <preset_or_list> [...]\n"
+             "       shader_deploy.py [--silent] [--jobs N] --check")
     if len(sys.argv) < 2:
-        print("Usage: shader_deploy.py [--LogToFile] [--silent] <preset_or_list> [...]")
+        print(usage)
         sys.exit(1)
 
     # Parse flags
     args = []
-    for a in sys.argv[1:]:
+    dry_run = check = False
+    jobs = os.cpu_count() or 1
+    argv = iter(sys.argv[1:])
+    for a in argv:
         if a == "--LogToFile":
             LogToFile = True
         elif a == "--silent":
             silent = True
+        elif a == "--dry-run":
+            dry_run = True
+        elif a == "--check":
+            check = True
+        elif a == "--jobs":
+            jobs = max(1, int(next(argv, "1")))
         else:
             args.append(a)
 
-    EXPORT_ROOT.mkdir(exist_ok=True)
-    presets = expand_preset_inputs(args)
+    if check:
+        presets = sorted(normalize(p) for p in REPO_ROOT.rglob("*.slangp") if ".git" not in p.parts)
+        dry_run = True
+    elif args:
+        presets = expand_preset_inputs(args)
+    else:
+        print(usage)
+        sys.exit(1)
+
+    # the JSON goes to stdout
+    if dry_run:
+        silent = True
 
-    for preset in presets:
-        process_file(preset)
+    load_index()
+    build_index(presets, jobs)
+    save_index()
+
+    if dry_run:
+        report = {index_key(p): closure_of(p) for p in presets}
+        if check:
+            print(json.dumps({"missing": sorted(missing), "circular": sorted(circular)}, indent=1))
+            sys.exit(2 if missing or circular else 0)
+        print(json.dumps(report, indent=1))
+    else:
+        for preset in presets:
+            process_file(preset)
+        export(processed, jobs)
 
     # Write dependency tree if requested
     if LogToFile:
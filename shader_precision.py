@@ -0,0 +1,399 @@
+#!/usr/bin/env python3
+
+############# Render Target Precision Audit Script ##############
+# license: public domain
+#  Use this script to find render targets that are wider
+#    than the output needs. It runs from the top-level of
+#    the slang shader repo and takes presets the same way
+#    as shader_bench.py (paths, wildcards or a *.txt list).
+#
+#  Without RetroArch it only lists, per intermediate
+#    pass, the format the pass renders to, where that
+#    format comes from (#pragma format, float_framebuffer,
+#    srgb_framebuffer or the default) and its bytes.
+#
+#  EXPERIMENTAL: the measurement below has only been
+#    run against a stand-in for RetroArch, never with a
+#    Vulkan driver, so check its recommendations by hand.
+#
+#  With --retroarch/--core and one or more --content
+#    files (the test frames, e.g. PNGs loaded with the
+#    image viewer core) every float or 32-bit pass is
+#    narrowed in a scratch copy of the preset, narrowest
+#    candidate first:
+#      R8G8B8A8_UNORM, R8G8B8A8_SRGB,
+#      A2B10G10R10_UNORM_PACK32, R16G16B16A16_SFLOAT
+#    (R8/R8G8_UNORM and R16/R16G16_SFLOAT for one and two
+#    channel targets). The final image of every test frame
+#    is compared against the unmodified preset. A candidate
+#    is kept when no channel is more than --tolerance 8-bit
+#    codes off on more than --outliers of the pixels. So the
+#    range and precision an intermediate needs are measured
+#    by their effect on the output, which is what the bound
+#    is defined on. Passes are narrowed in order, each with
+#    the earlier recommendations applied, so the recommended
+#    formats are also safe together.
+#    E.g. against lavapipe in a headless X server:
+#      VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json \
+#      xvfb-run -a ./shader_precision.py crt/crt-guest-advanced.slangp \
+#        --retroarch retroarch --core cores/imageviewer_libretro.so \
+#        --content frames/*.png
+#
+#  Packed float formats such as B10G11R11_UFLOAT_PACK32
+#    are not render target formats of the slang spec, so
+#    they are not tried. Integer formats carry data, not
+#    colors, and are left alone.
+#
+#  Everything is written to a JSON report.
+#
+##########################################################
+
+import argparse
+import glob
+import json
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+from pathlib import Path
+
+from shader_bench import (COMMENT_RE, FORMAT_BYTES, FORMAT_RE, REPO_ROOT, expand_inputs,
+                          expand_source, pass_size, preset_path, read_preset, rel, to_bool)
+
+# ------------------------------------------------------------
+# CONFIG
+# ------------------------------------------------------------
+
+DEFAULT_REPORT = REPO_ROOT / "shader_precision_report.json"
+SCRATCH_SUFFIX = ".precision-audit.slang"
+
+VERSION_RE = re.compile(r'^\s*#version\b[^\n]*\n', re.M)
+FORMAT_LINE_RE = re.compile(r'^\s*#pragma\s+format\s+\w+[^\n]*$', re.M)
+
+# narrowest first; only ones smaller than the current format are tried
+CANDIDATES = {
+    1: ("R8_UNORM", "R16_SFLOAT"),
+    2: ("R8G8_UNORM", "R16G16_SFLOAT"),
+    4: ("R8G8B8A8_UNORM", "R8G8B8A8_SRGB", "A2B10G10R10_UNORM_PACK32", "R16G16B16A16_SFLOAT"),
+}
+
+# preset keys that hold paths
+PATH_KEY_RE = re.compile(r'^shader\d+$')
+
+# ------------------------------------------------------------
+# UTILITY
+# ------------------------------------------------------------
+
+silent = False
+
+def log(msg: str):
+    if not silent:
+        print(msg, file=sys.stderr)
+
+def channels(fmt: str) -> int:
+    if fmt.startswith("A2B10G10R10"):
+        return 4
+    return len(re.findall(r'[RGBA]\d+', fmt.split("_")[0]))
+
+def is_float(fmt: str) -> bool:
+    return fmt.endswith("_SFLOAT")
+
+def read_png(path: Path):
+    """(width, height, channels, bytes) of an 8-bit non-interlaced PNG."""
+    data = path.read_bytes()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(f"not a PNG: {path}")
+    pos, idat, header = 8, [], None
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        if kind == b"IHDR":
+            header = struct.unpack(">IIBBBBB", chunk)
+        elif kind == b"IDAT":
+            idat.append(chunk)
+        elif kind == b"IEND":
+            break
+        pos += 12 + length
+    w, h, depth, color, _, _, interlace = header
+    bpp = {0: 1, 2: 3, 4: 2, 6: 4}.get(color)
+    if depth != 8 or bpp is None or interlace:
+        raise ValueError(f"unsupported PNG layout: {path}")
+    raw = zlib.decompress(b"".join(idat))
+    stride = w * bpp
+    out = bytearray(h * stride)
+    prev = bytearray(stride)
+    for y in range(h):
+        kind = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        if kind == 1:
+            for i in range(bpp, stride):
+                line[i] = (line[i] + line[i - bpp]) & 0xFF
+        elif kind == 2:
+            for i in range(stride):
+                line[i] = (line[i] + prev[i]) & 0xFF
+        elif kind == 3:
+            for i in range(stride):
+                left = line[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + ((left + prev[i]) >> 1)) & 0xFF
+        elif kind == 4:
+            for i in range(stride):
+                a = line[i - bpp] if i >= bpp else 0
+                b = prev[i]
+                c = prev[i - bpp] if i >= bpp else 0
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[i] = (line[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+        out[y * stride:(y + 1) * stride] = line
+        prev = line
+    return w, h, bpp, bytes(out)
+
+def image_error(reference, image, tolerance: int):
+    """(largest channel difference, fraction of pixels beyond tolerance)."""
+    if reference[:3] != image[:3]:
+        return 255, 1.0
+    w, h, bpp, a = reference
+    b = image[3]
+    worst, beyond = 0, 0
+    for i in range(0, len(a), bpp):
+        d = max(abs(a[i + c] - b[i + c]) for c in range(min(bpp, 3)))
+        if d > tolerance:
+            beyond += 1
+        worst = max(worst, d)
+    return worst, beyond / (w * h)
+
+# ------------------------------------------------------------
+# PRESET ANALYSIS
+# ------------------------------------------------------------
+
+def pass_formats(preset: Path, original, viewport) -> list[dict]:
+    """Format, origin, size and bytes of every pass rendering to a texture."""
+    settings = read_preset(preset)
+    values = {key: value for key, (value, _) in settings.items()}
+    count = int(values.get("shaders", 0))
+    passes, source = [], original
+    for i in range(count):
+        shader = preset_path(settings, f"shader{i}")
+        size = pass_size(values, i, count, source, original, viewport)
+        source = size
+        if i == count - 1:
+            break  # the last pass renders to the backbuffer
+        if not shader or not shader.exists():
+            raise ValueError(f"missing shader{i}")
+        fmt = FORMAT_RE.search(COMMENT_RE.sub("", expand_source(shader)))
+        if fmt:
+            # only a pragma in the shader itself can be swapped in a copy
+            own = FORMAT_RE.search(COMMENT_RE.sub("", shader.read_text(encoding="utf-8", errors="ignore")))
+            fmt, origin = fmt.group(1), "pragma" if own else "pragma in an include"
+        elif to_bool(values.get(f"float_framebuffer{i}", "false")):
+            fmt, origin = "R16G16B16A16_SFLOAT", "float_framebuffer"
+        elif to_bool(values.get(f"srgb_framebuffer{i}", "false")):
+            fmt, origin = "R8G8B8A8_SRGB", "srgb_framebuffer"
+        else:
+            fmt, origin = "R8G8B8A8_UNORM", "default"
+        passes.append({
+            "pass": i,
+            "shader": rel(shader),
+            "format": fmt,
+            "origin": origin,
+            "size": list(size),
+            "bytes": size[0] * size[1] * FORMAT_BYTES.get(fmt, 4),
+        })
+    return passes
+
+def candidates(fmt: str) -> list[str]:
+    if not is_float(fmt):
+        return []
+    current = FORMAT_BYTES.get(fmt, 4)
+    return [c for c in CANDIDATES.get(channels(fmt), ()) if FORMAT_BYTES[c] < current]
+
+# ------------------------------------------------------------
+# MEASUREMENT
+# ------------------------------------------------------------
+
+def write_scratch_preset(preset: Path, overrides: dict, scratch: list[Path]) -> Path:
+    """A flattened copy of the preset with absolute paths, where the passes in
+    overrides render to the given format. The shader copies are written next
+    to the originals so their relative #includes still resolve."""
+    settings = read_preset(preset)
+    textures = {t.strip() for t in settings.get("textures", ("", None))[0].split(";") if t.strip()}
+    lines = []
+    for key, (value, origin) in settings.items():
+        if PATH_KEY_RE.match(key) or key in textures:
+            value = str(preset_path(settings, key))
+        lines.append(f'{key} = "{value}"')
+    for i, fmt in overrides.items():
+        shader = preset_path(settings, f"shader{i}")
+        text = shader.read_text(encoding="utf-8", errors="ignore")
+        pragma = f"#pragma format {fmt}"
+        if FORMAT_LINE_RE.search(text):
+            text = FORMAT_LINE_RE.sub(pragma, text, count=1)
+        else:
+            text = VERSION_RE.sub(lambda m: m.group(0) + "\n" + pragma + "\n", text, count=1)
+        copy = shader.with_name(f"{shader.stem}.pass{i}{SCRATCH_SUFFIX}")
+        copy.write_text(text, encoding="utf-8")
+        scratch.append(copy)
+        lines += [f'shader{i} = "{copy}"', f'float_framebuffer{i} = "false"',
+                  f'srgb_framebuffer{i} = "false"']
+    fd, name = tempfile.mkstemp(suffix=".slangp")
+    with os.fdopen(fd, "w", encoding="utf-8") as f:
+        f.write("\n".join(lines) + "\n")
+    scratch.append(Path(name))
+    return Path(name)
+
+def render(args, preset: Path, content: str, viewport):
+    """The final image of the preset after args.frames frames, or None."""
+    with tempfile.TemporaryDirectory() as tmp:
+        cfg = Path(tmp) / "retroarch.cfg"
+        shot = Path(tmp) / "frame.png"
+        cfg.write_text(
+            'video_driver = "vulkan"\n'
+            'video_vsync = "false"\n'
+            'video_fullscreen = "false"\n'
+            'video_window_save_positions = "true"\n'
+            f'window_position_width = "{viewport[0]}"\n'
+            f'window_position_height = "{viewport[1]}"\n'
+            'video_scale_integer = "false"\n'
+            'video_gpu_screenshot = "true"\n'
+            'audio_driver = "null"\n'
+            'pause_nonactive = "false"\n'
+            'video_shader_enable = "true"\n')
+        cmd = [args.retroarch, "--appendconfig", str(cfg), f"--max-frames={args.frames}",
+               "--max-frames-ss", f"--max-frames-ss-path={shot}",
+               "--set-shader", str(preset), "-L", args.core, content]
+        try:
+            subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                           timeout=args.timeout, check=True)
+            return read_png(shot)
+        except (subprocess.SubprocessError, OSError, ValueError):
+            return None
+
+def within_bound(args, preset: Path, overrides: dict, references: list, viewport):
+    """Worst (difference, outlier fraction) over the test frames, and whether
+    it is within the bound."""
+    scratch = []
+    try:
+        scratch_preset = write_scratch_preset(preset, overrides, scratch)
+        worst, outliers = 0, 0.0
+        for content, reference in zip(args.content, references):
+            image = render(args, scratch_preset, content, viewport)
+            if image is None:
+                return (255, 1.0), False
+            d, f = image_error(reference, image, args.tolerance)
+            worst, outliers = max(worst, d), max(outliers, f)
+            if outliers > args.outliers:
+                return (worst, outliers), False
+        return (worst, outliers), True
+    finally:
+        for path in scratch:
+            path.unlink(missing_ok=True)
+
+def audit_preset(args, preset: Path, passes: list[dict], viewport) -> dict:
+    references, again = [], []
+    for content in args.content:
+        references.append(render(args, preset, content, viewport))
+        again.append(render(args, preset, content, viewport))
+    if any(r is None for r in references + again):
+        return {"error": "the reference run failed"}
+    if any(a[3] != b[3] for a, b in zip(references, again)):
+        return {"error": "the preset does not render the same frame twice"}
+
+    chosen = {}
+    for p in passes:
+        p["recommended"] = p["format"]
+        for fmt in p["candidates"]:
+            (worst, outliers), ok = within_bound(args, preset, {**chosen, p["pass"]: fmt},
+                                                 references, viewport)
+            log(f"  pass {p['pass']} {fmt}: max {worst}, {outliers:.4%} beyond tolerance"
+                f"{'' if ok else ' (rejected)'}")
+            if ok:
+                chosen[p["pass"]] = fmt
+                p["recommended"] = fmt
+                p["max_error"] = worst
+                break
+    return {}
+
+# ------------------------------------------------------------
+# MAIN
+# ------------------------------------------------------------
+
+def main():
+    global silent
+    parser = argparse.ArgumentParser(
+        description="Find the narrowest safe render target formats of slang presets.",
+        epilog="The measurement (--retroarch/--core/--content) is experimental: it has not "
+               "been run with a Vulkan driver yet, so check its recommendations by hand.")
+    parser.add_argument("presets", nargs="*", help="presets, wildcards or a *.txt list (default: all)")
+    parser.add_argument("--input", default="320x240", help="input (Original) size, default 320x240")
+    parser.add_argument("--output", default="1280x960", help="output (viewport) size, default 1280x960")
+    parser.add_argument("--report", default=str(DEFAULT_REPORT), help="report to write")
+    parser.add_argument("--retroarch", help="RetroArch binary, enables the (experimental) measurement")
+    parser.add_argument("--core", help="libretro core showing the test frames")
+    parser.add_argument("--content", nargs="+", default=[], help="test frames (content for the core)")
+    parser.add_argument("--frames", type=int, default=60, help="frame whose output is compared")
+    parser.add_argument("--tolerance", type=int, default=1, help="8-bit codes a channel may differ by")
+    parser.add_argument("--outliers", type=float, default=0.0,
+                        help="fraction of pixels allowed beyond the tolerance")
+    parser.add_argument("--timeout", type=float, default=120.0, help="seconds before a run is abandoned")
+    parser.add_argument("--silent", action="store_true")
+    args = parser.parse_args()
+    silent = args.silent
+
+    original = tuple(int(v) for v in args.input.lower().split("x"))
+    viewport = tuple(int(v) for v in args.output.lower().split("x"))
+    args.content = [c for pattern in args.content for c in (sorted(glob.glob(pattern)) or [pattern])]
+    measuring = bool(args.retroarch and args.core and args.content)
+    if measuring:
+        log("The measurement is experimental, check its recommendations by hand.")
+
+    presets, saved = {}, 0
+    for preset in expand_inputs(args.presets):
+        name = rel(preset)
+        try:
+            passes = pass_formats(preset, original, viewport)
+        except (OSError, ValueError) as e:
+            log(f"WARNING: {name}: {e}")
+            continue
+        for p in passes:
+            p["candidates"] = candidates(p["format"]) if p["origin"] != "pragma in an include" else []
+        result = {"passes": passes}
+        audited = [p for p in passes if p["candidates"]]
+        if measuring and audited:
+            log(f"{name}: auditing {len(audited)} of {len(passes)} render targets")
+            result.update(audit_preset(args, preset, audited, viewport))
+            for p in audited:
+                if p.get("recommended", p["format"]) != p["format"]:
+                    narrow = p["size"][0] * p["size"][1] * FORMAT_BYTES[p["recommended"]]
+                    p["saved_bytes"] = p["bytes"] - narrow
+                    saved += p["saved_bytes"]
+                    print(f"{name}: pass {p['pass']} ({p['shader']}): "
+                          f"{p['format']} -> {p['recommended']}")
+        else:
+            log(f"{name}: {len(audited)} of {len(passes)} render targets are float")
+        presets[name] = result
+
+    try:
+        commit = subprocess.run(["git", "rev-parse", "HEAD"], capture_output=True,
+                                text=True, cwd=REPO_ROOT).stdout.strip() or None
+    except OSError:
+        commit = None
+    report = {
+        "commit": commit,
+        "input": list(original),
+        "output": list(viewport),
+        "measured": measuring,
+        "tolerance": args.tolerance if measuring else None,
+        "outliers": args.outliers if measuring else None,
+        "content": args.content if measuring else [],
+        "saved_bytes": saved,
+        "presets": presets,
+    }
+    with open(args.report, "w", encoding="utf-8") as f:
+        json.dump(report, f, indent=1, sort_keys=True)
+        f.write("\n")
+    log(f"Report written to {args.report}")
+
+if __name__ == "__main__":
+    main()